@@ -4,25 +4,9 @@
 #
 #-------------------------------------------------
 
-TEMPLATE = app
+TEMPLATE = subdirs
 
-QT += core gui widgets
+SUBDIRS = app libtfa
 
-SOURCES += \
-    main.cpp \
-    mainwindow.cpp \
-    wavreader.cpp \
-    srtwriter.cpp
-
-HEADERS += \
-    mainwindow.h \
-    wavreader.h \
-    srtwriter.h
-
-FORMS += mainwindow.ui
-
-RESOURCES += TFA.qrc
-
-RC_FILE = TFA.rc
-
-TARGET = TFA
+app.file = app.pro
+libtfa.file = libtfa.pro
@@ -0,0 +1,34 @@
+TEMPLATE = app
+
+QT += core gui widgets concurrent network
+
+SOURCES += \
+    main.cpp \
+    mainwindow.cpp \
+    wavreader.cpp \
+    srtwriter.cpp \
+    detector.cpp \
+    job.cpp \
+    jobserver.cpp \
+    histogram.cpp \
+    rangemin.cpp \
+    ringbuffer.cpp
+
+HEADERS += \
+    mainwindow.h \
+    wavreader.h \
+    srtwriter.h \
+    detector.h \
+    job.h \
+    jobserver.h \
+    histogram.h \
+    rangemin.h \
+    ringbuffer.h
+
+FORMS += mainwindow.ui
+
+RESOURCES += TFA.qrc
+
+RC_FILE = TFA.rc
+
+TARGET = TFA
@@ -0,0 +1,208 @@
+/*
+ * This file is part of TFA.
+ * Copyright (C) 2013-2025  Andrey Efremov <duxus@yandex.ru>
+ *
+ * TFA is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TFA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TFA.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "detector.h"
+#include "rangemin.h"
+#include <QtConcurrent>
+#include <cmath>
+#include <limits>
+
+namespace Detector
+{
+Detector::Detector(const Params &params, const quint32 sampleRate) :
+    Detector(QList<Params>{params}, sampleRate)
+{
+}
+
+Detector::Detector(const QList<Params> &params, const quint32 sampleRate) :
+    _samplesInMsec(sampleRate * 0.001),
+    _minThreshold(std::numeric_limits<qreal>::max()),
+    _hasMaxLength(false)
+{
+    for (const Params &p : params) {
+        _thresholds.append(p.threshold);
+        _minIntervals.append(qRound(p.minInterval * _samplesInMsec));
+        _minLengths.append(p.minLength);
+        _maxLengths.append(p.maxLength);
+        _minThreshold = qMin(_minThreshold, p.threshold);
+        _hasMaxLength = _hasMaxLength || p.maxLength > 0;
+    }
+    reset();
+}
+
+int Detector::size() const
+{
+    return _thresholds.size();
+}
+
+void Detector::reset()
+{
+    const int count = size();
+    _position = 0;
+    _msecEnd = 0;
+    _envelope.clear();
+    _countdowns = _minIntervals;
+    _inPhrase.fill(false, count);
+    _starts.fill(0, count);
+    _lastSeenTimes.fill(0, count);
+    _intervals.fill(IntervalList(), count);
+}
+
+void Detector::closePhrase(const int index)
+{
+    _inPhrase[index] = false;
+    const Interval phrase(_starts.at(index), _lastSeenTimes.at(index) + 1);
+    if (static_cast<int>(phrase.second) - static_cast<int>(phrase.first) >= _minLengths.at(index)) {
+        _intervals[index].append(phrase);
+    }
+}
+
+void Detector::process(const qreal sample)
+{
+    const qreal amplitude = qAbs(sample);
+
+    // Огибающая нужна только для разбиения длинных фраз
+    if (_hasMaxLength) {
+        while (_position >= _msecEnd) {
+            _envelope.append(0.0f);
+            // Миллисекунда m - сэмплы, которые округляются к m
+            _msecEnd = static_cast<qint64>(std::ceil((_envelope.size() - 0.5) * _samplesInMsec));
+        }
+        _envelope.last() = qMax(_envelope.last(), static_cast<float>(amplitude));
+    }
+
+    // Время нужно только когда сэмпл выше хотя бы одного порога
+    const uint time = amplitude >= _minThreshold ? static_cast<uint>(qRound64(_position / _samplesInMsec)) : 0;
+
+    const qreal *thresholds = _thresholds.constData();
+    const int *minIntervals = _minIntervals.constData();
+    int *countdowns = _countdowns.data();
+    bool *inPhrase = _inPhrase.data();
+    uint *starts = _starts.data();
+    uint *lastSeenTimes = _lastSeenTimes.data();
+    for (int i = 0, count = size(); i < count; ++i) {
+        if (amplitude >= thresholds[i]) {
+            lastSeenTimes[i] = time;
+            countdowns[i] = minIntervals[i];
+
+            if (!inPhrase[i]) {
+                inPhrase[i] = true;
+                starts[i] = time;
+            }
+        } else if (inPhrase[i]) {
+            if (countdowns[i] > 0) {
+                --countdowns[i];
+            } else {
+                closePhrase(i);
+            }
+        }
+    }
+    ++_position;
+}
+
+void Detector::process(const qreal *samples, const qint64 count)
+{
+    for (qint64 i = 0; i < count; ++i) {
+        process(samples[i]);
+    }
+}
+
+void Detector::finish()
+{
+    for (int i = 0, count = size(); i < count; ++i) {
+        if (_inPhrase.at(i)) {
+            closePhrase(i);
+        }
+    }
+
+    if (_hasMaxLength) {
+        splitLongPhrases();
+    }
+}
+
+void Detector::splitLongPhrases()
+{
+    // Каждый поиск самого тихого места - запрос O(1), поэтому разбиение линейно по числу фраз
+    const RangeMin::RangeMin quietest(_envelope);
+    for (int i = 0, count = size(); i < count; ++i) {
+        const int maxLength = _maxLengths.at(i),
+                  minLength = _minLengths.at(i);
+        if (maxLength <= 0) {
+            continue;
+        }
+
+        IntervalList result;
+        for (const Interval &phrase : _intervals.at(i)) {
+            uint start = phrase.first;
+            while (phrase.second - start > static_cast<uint>(maxLength)) {
+                // Разрез не раньше половины допустимой длины, и обе части не короче минимальной фразы
+                const int begin = static_cast<int>(start),
+                          end = static_cast<int>(phrase.second),
+                          shortest = qMax(minLength, 1);
+                int from = begin + qMax(shortest, maxLength / 2),
+                    to = qMin(begin + maxLength, end - shortest);
+                if (from > to) {
+                    // В допустимой длине места нет: режем в любом месте, где обе части не короче минимальной
+                    from = begin + shortest;
+                    to = end - shortest;
+                }
+                const int cut = from <= to ? quietest.indexOfMin(from, to) : -1;
+                if (cut < from || cut > to) {
+                    // Разрезать без слишком короткой части нельзя - остаток остаётся целым
+                    break;
+                }
+                result.append(Interval(start, static_cast<uint>(cut)));
+                start = static_cast<uint>(cut);
+            }
+            result.append(Interval(start, phrase.second));
+        }
+        _intervals[i] = result;
+    }
+}
+
+const IntervalList &Detector::intervals(const int index) const
+{
+    return _intervals.at(index);
+}
+
+IntervalList detect(const WavReader::SamplesList &samples, const quint32 sampleRate, const Params &params)
+{
+    return detect(samples, sampleRate, QList<Params>{params}).first();
+}
+
+QList<IntervalList> detect(const WavReader::SamplesList &samples, const quint32 sampleRate, const QList<Params> &params)
+{
+    Detector detector(params, sampleRate);
+    detector.process(samples.constData(), samples.size());
+    detector.finish();
+
+    QList<IntervalList> result;
+    for (int i = 0; i < detector.size(); ++i) {
+        result.append(detector.intervals(i));
+    }
+    return result;
+}
+
+QList<QList<IntervalList>> detectChannels(const QList<WavReader::SamplesList> &channels, const quint32 sampleRate, const QList<Params> &params)
+{
+    // Каналы независимы, поэтому каждый обрабатывается в своём потоке
+    return QtConcurrent::blockingMapped<QList<QList<IntervalList>>>(channels, [sampleRate, params](const WavReader::SamplesList &samples) {
+        return detect(samples, sampleRate, params);
+    });
+}
+}
@@ -0,0 +1,81 @@
+/*
+ * This file is part of TFA.
+ * Copyright (C) 2013-2025  Andrey Efremov <duxus@yandex.ru>
+ *
+ * TFA is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TFA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TFA.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DETECTOR_H
+#define DETECTOR_H
+
+#include "wavreader.h"
+#include <QPair>
+#include <QList>
+
+namespace Detector
+{
+struct Params
+{
+    qreal threshold;   // 0..1
+    int minInterval;   // мс
+    int minLength;     // мс
+    int maxLength;     // мс, 0 - без ограничения
+};
+
+typedef QPair<uint, uint> Interval; // мс
+typedef QList<Interval> IntervalList;
+
+// Потоковый детектор фраз: сэмплы подаются по одному, без промежуточных буферов.
+// Может вести сразу несколько наборов параметров за один проход; состояние
+// наборов хранится по полям в непрерывных массивах, чтобы цикл по ним шёл подряд в памяти.
+class Detector
+{
+    qreal _samplesInMsec;
+    qreal _minThreshold;
+    qint64 _position;
+    bool _hasMaxLength;
+    qint64 _msecEnd;
+    QList<float> _envelope; // пик амплитуды за каждую миллисекунду
+    QList<qreal> _thresholds;
+    QList<int> _minIntervals; // сэмплы
+    QList<int> _minLengths;   // мс
+    QList<int> _maxLengths;   // мс
+    QList<int> _countdowns;
+    QList<bool> _inPhrase;
+    QList<uint> _starts;
+    QList<uint> _lastSeenTimes;
+    QList<IntervalList> _intervals;
+
+    void closePhrase(int index);
+    void splitLongPhrases();
+
+public:
+    explicit Detector(const Params &params, quint32 sampleRate);
+    explicit Detector(const QList<Params> &params, quint32 sampleRate);
+
+    int size() const;
+    void reset();
+    void process(qreal sample);
+    void process(const qreal *samples, qint64 count);
+    void finish();
+    const IntervalList &intervals(int index = 0) const;
+};
+
+IntervalList detect(const WavReader::SamplesList &samples, quint32 sampleRate, const Params &params);
+QList<IntervalList> detect(const WavReader::SamplesList &samples, quint32 sampleRate, const QList<Params> &params);
+// Результат: [канал][набор параметров]
+QList<QList<IntervalList>> detectChannels(const QList<WavReader::SamplesList> &channels, quint32 sampleRate, const QList<Params> &params);
+}
+
+#endif // DETECTOR_H
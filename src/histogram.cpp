@@ -0,0 +1,139 @@
+/*
+ * This file is part of TFA.
+ * Copyright (C) 2013-2025  Andrey Efremov <duxus@yandex.ru>
+ *
+ * TFA is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TFA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TFA.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "histogram.h"
+#include <cmath>
+#include <cstring>
+
+namespace Histogram
+{
+Histogram::Histogram(const qint64 window)
+{
+    reset(window);
+}
+
+void Histogram::reset(const qint64 window)
+{
+    std::memset(_bins, 0, sizeof(_bins));
+    _window = qMax<qint64>(window, 1);
+    _count = 0;
+    _sum = 0.0;
+}
+
+void Histogram::flush()
+{
+    const qreal rms = std::sqrt(_sum / _count);
+    int bin = 0;
+    if (rms > 0.0) {
+        const qreal db = 20.0 * std::log10(rms);
+        bin = qBound(0, static_cast<int>(std::floor((db - MIN_DB) / STEP_DB)) + 1, BINS - 1);
+    }
+    ++_bins[bin];
+
+    _count = 0;
+    _sum = 0.0;
+}
+
+void Histogram::add(const qreal *samples, qint64 count)
+{
+    while (count > 0) {
+        const qint64 size = qMin(count, _window - _count);
+
+        // Независимые частичные суммы позволяют компилятору векторизовать цикл
+        qreal sums[4] = {0.0, 0.0, 0.0, 0.0};
+        qint64 i = 0;
+        for (; i + 4 <= size; i += 4) {
+            sums[0] += samples[i] * samples[i];
+            sums[1] += samples[i + 1] * samples[i + 1];
+            sums[2] += samples[i + 2] * samples[i + 2];
+            sums[3] += samples[i + 3] * samples[i + 3];
+        }
+        for (; i < size; ++i) {
+            sums[0] += samples[i] * samples[i];
+        }
+        _sum += (sums[0] + sums[1]) + (sums[2] + sums[3]);
+
+        _count += size;
+        samples += size;
+        count -= size;
+        if (_count == _window) {
+            flush();
+        }
+    }
+}
+
+void Histogram::finish()
+{
+    if (_count > 0) {
+        flush();
+    }
+}
+
+void Histogram::merge(const Histogram &other)
+{
+    for (int i = 0; i < BINS; ++i) {
+        _bins[i] += other._bins[i];
+    }
+}
+
+quint64 Histogram::total() const
+{
+    quint64 result = 0;
+    for (int i = 0; i < BINS; ++i) {
+        result += _bins[i];
+    }
+    return result;
+}
+
+qreal Histogram::percentile(const qreal p, const bool skipSilence) const
+{
+    // Накопленная сумма по корзинам вместо сортировки
+    const quint64 count = total() - (skipSilence ? _bins[0] : 0);
+    if (count == 0) {
+        return 0.0;
+    }
+
+    const quint64 target = static_cast<quint64>(std::ceil(qBound(0.0, p, 1.0) * count));
+    quint64 sum = 0;
+    int bin = skipSilence ? 1 : 0;
+    for (; bin < BINS - 1; ++bin) {
+        sum += _bins[bin];
+        if (sum >= target && sum > 0) {
+            break;
+        }
+    }
+
+    if (bin == 0) {
+        return 0.0;
+    }
+    return std::pow(10.0, (MIN_DB + (bin - 0.5) * STEP_DB) / 20.0);
+}
+
+qreal Histogram::threshold() const
+{
+    if (total() == 0) {
+        return 0.0;
+    }
+
+    // Шум - нижние 10% окон, речь - верхние 5%; порог - середина между ними в дБ.
+    // Цифровая тишина (например, в нарезанных дорожках диалогов) - не шум помещения, её не учитываем
+    const qreal noise = qMax(percentile(0.10, true), std::pow(10.0, MIN_DB / 20.0)),
+                speech = qMax(percentile(0.95, true), noise);
+    return qMin(std::sqrt(noise * speech), 1.0);
+}
+}
@@ -0,0 +1,57 @@
+/*
+ * This file is part of TFA.
+ * Copyright (C) 2013-2025  Andrey Efremov <duxus@yandex.ru>
+ *
+ * TFA is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TFA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TFA.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <QtGlobal>
+
+namespace Histogram
+{
+// Гистограмма уровня (RMS короткими окнами) в дБFS с фиксированными корзинами.
+// Заполняется потоково, без хранения сэмплов; гистограммы разных потоков можно складывать.
+class Histogram
+{
+public:
+    static constexpr int BINS = 241;          // 0 - тишина и всё ниже MIN_DB
+    static constexpr qreal MIN_DB = -120.0,
+                           STEP_DB = 0.5;
+
+private:
+    quint64 _bins[BINS];
+    qint64 _window;
+    qint64 _count;
+    qreal _sum;
+
+    void flush();
+
+public:
+    explicit Histogram(qint64 window = 1);
+
+    void reset(qint64 window);
+    void add(const qreal *samples, qint64 count);
+    void finish();
+    void merge(const Histogram &other);
+    quint64 total() const;
+    // skipSilence - без окон цифровой тишины (корзина 0)
+    qreal percentile(qreal p, bool skipSilence = false) const;
+    qreal threshold() const;
+};
+}
+
+#endif // HISTOGRAM_H
@@ -0,0 +1,346 @@
+/*
+ * This file is part of TFA.
+ * Copyright (C) 2013-2025  Andrey Efremov <duxus@yandex.ru>
+ *
+ * TFA is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TFA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TFA.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "job.h"
+#include <QSettings>
+#include <QFileInfo>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QJsonArray>
+#include <algorithm>
+
+namespace Job
+{
+Params defaultParams()
+{
+    // Те же ключи и значения по умолчанию, что и в главном окне
+    const QSettings settings;
+    Params params;
+    params.format = "srt";
+    params.detector.threshold = settings.value("Threshold", 5.0).toDouble() * 0.01;
+    params.detector.minInterval = settings.value("MinInterval", 200).toInt();
+    params.detector.minLength = settings.value("MinLength", 200).toInt();
+    params.detector.maxLength = settings.value("MaxLength", 0).toInt();
+    params.autoThreshold = settings.value("AutoThreshold", false).toBool();
+    params.perChannel = settings.value("PerChannel", false).toBool();
+    params.readAhead = settings.value("ReadAhead", 0).toInt();
+    params.blockSize = settings.value("BlockSize", WavReader::DEFAULT_BLOCK_SIZE / 1024).toInt();
+    return params;
+}
+
+// Порог из JSON: проценты 0..100 или "auto"; если порог не указан - fallback
+static bool readThreshold(const QJsonValue &value, const qreal fallback, qreal *threshold)
+{
+    if (value.isUndefined()) {
+        *threshold = fallback;
+        return true;
+    }
+    if (value.isString()) {
+        return parseThreshold(value.toString(), threshold);
+    }
+    if (value.isDouble() && value.toDouble() >= 0.0 && value.toDouble() <= 100.0) {
+        *threshold = value.toDouble() * 0.01;
+        return true;
+    }
+    return false;
+}
+
+Params fromJson(const QJsonObject &json, const Params &defaults, QString *errorString)
+{
+    Params params = defaults;
+    params.input = json.value("input").toString();
+    params.output = json.value("output").toString(defaultOutput(params.input));
+    params.format = json.value("format").toString(defaults.format).toLower();
+    qreal threshold;
+    if (readThreshold(json.value("threshold"), defaults.autoThreshold ? AUTO_THRESHOLD : defaults.detector.threshold, &threshold)) {
+        params.autoThreshold = threshold == AUTO_THRESHOLD;
+        if (!params.autoThreshold) {
+            params.detector.threshold = threshold;
+        }
+    } else if (errorString != nullptr) {
+        *errorString = "Неправильный порог: нужны проценты от 0 до 100 или \"auto\".";
+    }
+    params.detector.minInterval = json.value("minInterval").toInt(defaults.detector.minInterval);
+    params.detector.minLength = json.value("minLength").toInt(defaults.detector.minLength);
+    params.detector.maxLength = json.value("maxLength").toInt(defaults.detector.maxLength);
+    params.perChannel = json.value("perChannel").toBool(defaults.perChannel);
+    params.readAhead = json.value("readAhead").toInt(defaults.readAhead);
+    params.blockSize = json.value("blockSize").toInt(defaults.blockSize);
+
+    if (json.contains("configs")) {
+        params.configs.clear();
+        for (const QJsonValue &value : json.value("configs").toArray()) {
+            const QJsonObject config = value.toObject();
+            // Без порога набор наследует общий, в том числе "auto"
+            qreal configThreshold = params.detector.threshold;
+            if (!readThreshold(config.value("threshold"), params.autoThreshold ? AUTO_THRESHOLD : params.detector.threshold,
+                               &configThreshold) && errorString != nullptr) {
+                *errorString = "Неправильный порог в наборе параметров: нужны проценты от 0 до 100 или \"auto\".";
+            }
+            params.configs.append(Detector::Params{
+                configThreshold,
+                config.value("minInterval").toInt(params.detector.minInterval),
+                config.value("minLength").toInt(params.detector.minLength),
+                config.value("maxLength").toInt(params.detector.maxLength)
+            });
+        }
+    }
+    return params;
+}
+
+static QJsonObject toJson(const Detector::Params &params)
+{
+    return {
+        {"threshold", params.threshold == AUTO_THRESHOLD ? QJsonValue("auto") : QJsonValue(params.threshold * 100.0)},
+        {"minInterval", params.minInterval},
+        {"minLength", params.minLength},
+        {"maxLength", params.maxLength}
+    };
+}
+
+QJsonObject toJson(const Params &params)
+{
+    QJsonObject json = {
+        {"input", params.input},
+        {"output", params.output},
+        {"format", params.format},
+        {"threshold", params.autoThreshold ? QJsonValue("auto") : QJsonValue(params.detector.threshold * 100.0)},
+        {"minInterval", params.detector.minInterval},
+        {"minLength", params.detector.minLength},
+        {"maxLength", params.detector.maxLength},
+        {"perChannel", params.perChannel},
+        {"readAhead", params.readAhead},
+        {"blockSize", params.blockSize}
+    };
+
+    if (!params.configs.isEmpty()) {
+        QJsonArray configs;
+        for (const Detector::Params &config : params.configs) {
+            configs.append(toJson(config));
+        }
+        json.insert("configs", configs);
+    }
+    return json;
+}
+
+QJsonObject toJson(const Result &result)
+{
+    QJsonArray outputs;
+    for (const Output &output : result.outputs) {
+        QJsonObject json = toJson(output.params);
+        json.insert("output", output.fileName);
+        json.insert("phrases", output.phrases);
+        json.insert("speechMsec", output.speech);
+        outputs.append(json);
+    }
+
+    QJsonObject json = {{"outputs", outputs}};
+    if (!result.summary.isEmpty()) {
+        json.insert("summary", result.summary);
+    }
+    if (result.ingest.blocks > 0) {
+        json.insert("ingest", QJsonObject{
+            {"blocks", result.ingest.blocks},
+            {"readerStallUsec", result.ingest.readerStall},
+            {"decoderStallUsec", result.ingest.decoderStall}
+        });
+    }
+    return json;
+}
+
+QString defaultOutput(const QString &input)
+{
+    const QFileInfo fileInfo(input);
+    return fileInfo.dir().filePath(fileInfo.completeBaseName() + ".srt");
+}
+
+QString configOutput(const QString &output, const int index)
+{
+    const QFileInfo fileInfo(output);
+    return fileInfo.dir().filePath(QString("%1.%2.%3").arg(fileInfo.completeBaseName()).arg(index + 1).arg(fileInfo.suffix()));
+}
+
+bool parseThreshold(const QString &text, qreal *threshold)
+{
+    if (text == "auto") {
+        *threshold = AUTO_THRESHOLD;
+        return true;
+    }
+
+    bool ok;
+    const qreal percent = text.toDouble(&ok);
+    if (!ok || percent < 0.0 || percent > 100.0) {
+        return false;
+    }
+    *threshold = percent * 0.01;
+    return true;
+}
+
+bool parseConfig(const QString &text, Detector::Params *params)
+{
+    // Формат: порог_%|auto:интервал_мс:длительность_мс[:макс_длительность_мс]
+    const QStringList parts = text.split(':');
+    if (parts.size() != 3 && parts.size() != 4) {
+        return false;
+    }
+
+    bool okInterval, okLength, okMaxLength = true;
+    const bool okThreshold = parseThreshold(parts.at(0), &params->threshold);
+    params->minInterval = parts.at(1).toInt(&okInterval);
+    params->minLength = parts.at(2).toInt(&okLength);
+    params->maxLength = parts.size() > 3 ? parts.at(3).toInt(&okMaxLength) : 0;
+    return okThreshold && okInterval && okLength && okMaxLength;
+}
+
+QString summaryTable(const Result &result)
+{
+    QString table = "config\tthreshold\tmin_interval\tmin_length\tmax_length\tphrases\tspeech_ms\toutput\n";
+    for (int i = 0; i < result.outputs.size(); ++i) {
+        const Output &output = result.outputs.at(i);
+        table += QString("%1\t%2\t%3\t%4\t%5\t%6\t%7\t%8\n")
+                 .arg(i + 1)
+                 .arg(output.params.threshold * 100.0)
+                 .arg(output.params.minInterval)
+                 .arg(output.params.minLength)
+                 .arg(output.params.maxLength)
+                 .arg(output.phrases)
+                 .arg(output.speech)
+                 .arg(output.fileName);
+    }
+    return table;
+}
+
+QString ingestTable(const Result &result)
+{
+    // Если простаивает в основном декодер, упираемся в диск, если поток чтения - в процессор
+    return QString("blocks\treader_stall_us\tdecoder_stall_us\n%1\t%2\t%3\n")
+           .arg(result.ingest.blocks)
+           .arg(result.ingest.readerStall)
+           .arg(result.ingest.decoderStall);
+}
+
+SrtWriter::PhraseList findPhrases(WavReader::WavReader &reader, const Detector::Params &params)
+{
+    return findPhrases(reader, QList<Detector::Params>{params}).first();
+}
+
+QList<SrtWriter::PhraseList> findPhrases(WavReader::WavReader &reader, const QList<Detector::Params> &params)
+{
+    const quint32 sampleRate = reader.format().sampleRate;
+    QList<SrtWriter::PhraseList> result(params.size());
+
+    if (reader.isPlanar()) {
+        const QList<QList<Detector::IntervalList>> tracks = Detector::detectChannels(reader.channels(), sampleRate, params);
+        for (int channel = 0; channel < tracks.size(); ++channel) {
+            for (int i = 0; i < params.size(); ++i) {
+                for (const Detector::Interval &interval : tracks.at(channel).at(i)) {
+                    result[i].append(SrtWriter::Phrase{interval, QString("Канал %1").arg(channel + 1)});
+                }
+            }
+        }
+        for (SrtWriter::PhraseList &phrases : result) {
+            std::stable_sort(phrases.begin(), phrases.end(), [](const SrtWriter::Phrase &a, const SrtWriter::Phrase &b) {
+                return a.time.first < b.time.first;
+            });
+        }
+    } else {
+        // Все наборы параметров обрабатываются за один проход по сэмплам
+        const QList<Detector::IntervalList> lists = Detector::detect(reader.samples(), sampleRate, params);
+        for (int i = 0; i < lists.size(); ++i) {
+            uint num = 1;
+            for (const Detector::Interval &interval : lists.at(i)) {
+                result[i].append(SrtWriter::Phrase{interval, QString::number(num)});
+                ++num;
+            }
+        }
+    }
+
+    return result;
+}
+
+static Result failure(const QString &errorString)
+{
+    return {false, errorString, {}, QString(), {}};
+}
+
+Result run(const Params &params, WavReader::WavReader &reader)
+{
+    if (params.format != "srt") {
+        return failure(QString("Неподдерживаемый формат вывода: %1").arg(params.format));
+    }
+
+    reader.setReadAhead(params.readAhead, static_cast<qint64>(params.blockSize) * 1024);
+    if (!reader.load(params.input, params.perChannel)) {
+        return failure(reader.errorString());
+    }
+
+    QList<Detector::Params> configs = params.configs;
+    if (configs.isEmpty()) {
+        Detector::Params detector = params.detector;
+        if (params.autoThreshold) {
+            detector.threshold = reader.histogram().threshold();
+        }
+        configs.append(detector);
+    }
+    for (Detector::Params &config : configs) {
+        if (config.threshold == AUTO_THRESHOLD) {
+            config.threshold = reader.histogram().threshold();
+        }
+    }
+
+    if (!reader.isPlanar()) {
+        reader.toMono();
+    }
+
+    const QList<SrtWriter::PhraseList> lists = findPhrases(reader, configs);
+    Result result = {true, QString(), {}, QString(), reader.ingestStats()};
+    for (int i = 0; i < lists.size(); ++i) {
+        const SrtWriter::PhraseList &phrases = lists.at(i);
+        const QString fileName = params.configs.isEmpty() ? params.output : configOutput(params.output, i);
+
+        SrtWriter::SrtWriter writer;
+        qint64 speech = 0;
+        for (const SrtWriter::Phrase &phrase : phrases) {
+            writer.addPhrase(phrase);
+            speech += phrase.time.second - phrase.time.first;
+        }
+
+        if (!writer.save(fileName)) {
+            return failure(writer.errorString());
+        }
+
+        result.outputs.append(Output{fileName, configs.at(i), static_cast<int>(phrases.size()), speech});
+    }
+
+    // Сводка для сравнения наборов параметров
+    if (!params.configs.isEmpty()) {
+        const QFileInfo fileInfo(params.output);
+        result.summary = fileInfo.dir().filePath(fileInfo.completeBaseName() + ".summary.tsv");
+
+        QFile fout(result.summary);
+        if (!fout.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            return failure("Не могу открыть файл сводки для записи.");
+        }
+        QTextStream(&fout) << summaryTable(result);
+        fout.close();
+    }
+
+    return result;
+}
+}
@@ -0,0 +1,80 @@
+/*
+ * This file is part of TFA.
+ * Copyright (C) 2013-2025  Andrey Efremov <duxus@yandex.ru>
+ *
+ * TFA is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TFA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TFA.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef JOB_H
+#define JOB_H
+
+#include "wavreader.h"
+#include "srtwriter.h"
+#include "detector.h"
+#include <QJsonObject>
+
+namespace Job
+{
+// Порог набора параметров, который определяется по уровню шума и речи в файле
+const qreal AUTO_THRESHOLD = -1.0;
+
+struct Params
+{
+    QString input;
+    QString output;
+    QString format;
+    Detector::Params detector;
+    bool autoThreshold;
+    bool perChannel;
+    int readAhead; // блоков в очереди потока чтения, 0 - без отдельного потока
+    int blockSize; // КиБ
+    // Несколько наборов параметров за один проход; если пусто, используется detector.
+    // В наборах порог может быть AUTO_THRESHOLD, а autoThreshold на них не влияет
+    QList<Detector::Params> configs;
+};
+
+struct Output
+{
+    QString fileName;
+    Detector::Params params;
+    int phrases;
+    qint64 speech; // мс
+};
+
+struct Result
+{
+    bool ok;
+    QString errorString;
+    QList<Output> outputs;
+    QString summary; // файл сводки, если наборов параметров несколько
+    WavReader::IngestStats ingest;
+};
+
+Params defaultParams();
+Params fromJson(const QJsonObject &json, const Params &defaults, QString *errorString = nullptr);
+QJsonObject toJson(const Params &params);
+QJsonObject toJson(const Result &result);
+QString defaultOutput(const QString &input);
+QString configOutput(const QString &output, int index);
+bool parseThreshold(const QString &text, qreal *threshold);
+bool parseConfig(const QString &text, Detector::Params *params);
+QString summaryTable(const Result &result);
+QString ingestTable(const Result &result);
+
+SrtWriter::PhraseList findPhrases(WavReader::WavReader &reader, const Detector::Params &params);
+QList<SrtWriter::PhraseList> findPhrases(WavReader::WavReader &reader, const QList<Detector::Params> &params);
+Result run(const Params &params, WavReader::WavReader &reader);
+}
+
+#endif // JOB_H
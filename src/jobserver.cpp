@@ -0,0 +1,191 @@
+/*
+ * This file is part of TFA.
+ * Copyright (C) 2013-2025  Andrey Efremov <duxus@yandex.ru>
+ *
+ * TFA is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TFA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TFA.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "jobserver.h"
+#include <QJsonDocument>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QTextStream>
+
+
+// Буферы до 128 МиБ на поток остаются для следующих заданий
+static const qint64 KEEP_SAMPLES = (128 << 20) / sizeof(qreal);
+
+JobServer::JobServer(const Job::Params &defaults, QObject *parent) :
+    QObject(parent),
+    _defaults(defaults)
+{
+    // Потоки не завершаются между заданиями, чтобы сохранять свои буферы
+    _pool.setExpiryTimeout(-1);
+    connect(&_server, &QLocalServer::newConnection, this, &JobServer::acceptConnection);
+}
+
+bool JobServer::listen(const QString &name)
+{
+    // Сокет мог остаться от аварийно завершённого процесса; удаляем его, только если никто не отвечает
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if (probe.waitForConnected(1000)) {
+        probe.disconnectFromServer();
+        _errorString = QString("Демон %1 уже запущен.").arg(name);
+        return false;
+    }
+    QLocalServer::removeServer(name);
+
+    if (!_server.listen(name)) {
+        _errorString = _server.errorString();
+        return false;
+    }
+    return true;
+}
+
+QString JobServer::errorString() const
+{
+    return _errorString;
+}
+
+void JobServer::acceptConnection()
+{
+    while (_server.hasPendingConnections()) {
+        QLocalSocket* const socket = _server.nextPendingConnection();
+        connect(socket, &QLocalSocket::readyRead, this, &JobServer::readRequests);
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void JobServer::readRequests()
+{
+    QLocalSocket* const socket = qobject_cast<QLocalSocket*>(sender());
+    if (socket == nullptr) {
+        return;
+    }
+
+    while (socket->canReadLine()) {
+        const QByteArray line = socket->readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        QJsonParseError error;
+        const QJsonDocument document = QJsonDocument::fromJson(line, &error);
+        if (!document.isObject()) {
+            reply(socket, {{"status", "error"}, {"error", error.errorString()}});
+            continue;
+        }
+
+        submit(socket, document.object());
+    }
+}
+
+void JobServer::submit(QLocalSocket *socket, const QJsonObject &request)
+{
+    const QJsonValue id = request.value("id");
+    QString errorString;
+    const Job::Params params = Job::fromJson(request, _defaults, &errorString);
+    if (params.input.isEmpty()) {
+        errorString = "Не указан входной файл.";
+    }
+    if (!errorString.isEmpty()) {
+        reply(socket, {{"id", id}, {"status", "error"}, {"error", errorString}});
+        return;
+    }
+
+    reply(socket, {{"id", id}, {"status", "queued"}});
+
+    const QPointer<QLocalSocket> target(socket);
+    const auto post = [this, target](const QJsonObject &response) {
+        QMetaObject::invokeMethod(this, [this, target, response]() {
+            if (target) {
+                reply(target, response);
+            }
+        }, Qt::QueuedConnection);
+    };
+
+    _pool.start([id, params, post]() {
+        // Буферы сэмплов принадлежат потоку и переиспользуются следующими заданиями
+        thread_local WavReader::WavReader reader;
+
+        post({{"id", id}, {"status", "running"}});
+
+        QElapsedTimer timer;
+        timer.start();
+        const Job::Result result = Job::run(params, reader);
+        if (result.ok) {
+            QJsonObject response = Job::toJson(result);
+            response.insert("id", id);
+            response.insert("status", "done");
+            response.insert("msec", timer.elapsed());
+            post(response);
+        } else {
+            post({{"id", id}, {"status", "error"}, {"error", result.errorString}});
+        }
+
+        // Простаивающий поток не держит буферы длинных файлов
+        reader.release(KEEP_SAMPLES);
+    });
+}
+
+void JobServer::reply(QLocalSocket *socket, const QJsonObject &response)
+{
+    socket->write(QJsonDocument(response).toJson(QJsonDocument::Compact) + '\n');
+}
+
+int runClient(const QString &serverName, const QList<Job::Params> &jobs)
+{
+    QTextStream out(stdout), err(stderr);
+
+    QLocalSocket socket;
+    socket.connectToServer(serverName);
+    if (!socket.waitForConnected()) {
+        err << socket.errorString() << Qt::endl;
+        return 1;
+    }
+
+    for (int i = 0; i < jobs.size(); ++i) {
+        QJsonObject request = Job::toJson(jobs.at(i));
+        request.insert("id", i);
+        socket.write(QJsonDocument(request).toJson(QJsonDocument::Compact) + '\n');
+    }
+    socket.flush();
+
+    // Ответы печатаются по мере поступления, пока все задания не завершатся
+    qsizetype pending = jobs.size();
+    int failed = 0;
+    while (pending > 0) {
+        if (!socket.canReadLine() && !socket.waitForReadyRead(-1)) {
+            err << socket.errorString() << Qt::endl;
+            return 1;
+        }
+
+        while (socket.canReadLine()) {
+            const QByteArray line = socket.readLine();
+            out << line;
+            out.flush();
+
+            const QString status = QJsonDocument::fromJson(line).object().value("status").toString();
+            if (status == "done") {
+                --pending;
+            } else if (status == "error") {
+                --pending;
+                ++failed;
+            }
+        }
+    }
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * This file is part of TFA.
+ * Copyright (C) 2013-2025  Andrey Efremov <duxus@yandex.ru>
+ *
+ * TFA is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TFA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TFA.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef JOBSERVER_H
+#define JOBSERVER_H
+
+#include "job.h"
+#include <QObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QThreadPool>
+
+// Протокол: по одному JSON-объекту на строку в обе стороны.
+// Запрос: {"id", "input", "output", "format", "threshold" (% или "auto"), "minInterval", "minLength", "maxLength",
+//          "perChannel", "readAhead", "blockSize" (КиБ), "configs": [{"threshold" (% или "auto"), "minInterval", "minLength", "maxLength"}, ...]},
+// ответы: {"id", "status": "queued" | "running" | "done" | "error", "outputs", "summary", "ingest", ...}.
+class JobServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit JobServer(const Job::Params &defaults, QObject *parent = nullptr);
+    bool listen(const QString &name);
+    QString errorString() const;
+
+private slots:
+    void acceptConnection();
+    void readRequests();
+
+private:
+    QLocalServer _server;
+    QThreadPool _pool;
+    Job::Params _defaults;
+    QString _errorString;
+
+    void submit(QLocalSocket *socket, const QJsonObject &request);
+    void reply(QLocalSocket *socket, const QJsonObject &response);
+};
+
+int runClient(const QString &serverName, const QList<Job::Params> &jobs);
+
+#endif // JOBSERVER_H
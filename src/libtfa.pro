@@ -0,0 +1,30 @@
+TEMPLATE = lib
+
+CONFIG += shared hide_symbols
+
+QT = core concurrent
+
+DEFINES += TFA_LIBRARY
+
+SOURCES += \
+    tfa.cpp \
+    wavreader.cpp \
+    detector.cpp \
+    histogram.cpp \
+    rangemin.cpp \
+    ringbuffer.cpp
+
+HEADERS += \
+    tfa.h \
+    wavreader.h \
+    detector.h \
+    histogram.h \
+    rangemin.h \
+    ringbuffer.h
+
+# Исходники общие с программой, поэтому объектные файлы кладутся отдельно
+OBJECTS_DIR = .obj/libtfa
+
+TARGET = tfa
+
+VERSION = 1.0.1
@@ -17,31 +17,205 @@
  */
 
 #include "mainwindow.h"
+#include "jobserver.h"
 #include <QApplication>
 #include <QCommandLineParser>
+#include <QTextStream>
+#include <QElapsedTimer>
 
 
+// Режимы демона, клиента, проверки файлов и пакетной обработки работают без графического интерфейса
+static bool isHeadless(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--daemon") == 0 || qstrcmp(argv[i], "--client") == 0 || qstrcmp(argv[i], "--probe") == 0 ||
+            qstrncmp(argv[i], "--config", 8) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Несколько наборов параметров прямо в этом процессе, со сводкой в stdout
+static int runLocal(const QList<Job::Params> &jobs)
+{
+    QTextStream out(stdout), err(stderr);
+    WavReader::WavReader reader;
+    int failed = 0;
+    for (const Job::Params &params : jobs) {
+        const Job::Result result = Job::run(params, reader);
+        if (!result.ok) {
+            err << params.input << ": " << result.errorString << Qt::endl;
+            ++failed;
+            continue;
+        }
+
+        out << params.input << '\n' << Job::summaryTable(result);
+        if (result.ingest.blocks > 0) {
+            out << Job::ingestTable(result);
+        }
+        out << Qt::endl;
+    }
+
+    return failed > 0 ? 1 : 0;
+}
+
+// Сведения о файлах только по заголовкам, без декодирования
+static int runProbe(const QStringList &files)
+{
+    QTextStream out(stdout), err(stderr);
+    out << "file\tformat\tchannels\tsample_rate\tbits\tbyte_rate\tframes\tduration_us\tprobe_us\n";
+
+    WavReader::WavReader reader;
+    QElapsedTimer timer;
+    int failed = 0;
+    for (const QString &file : files) {
+        timer.start();
+        if (!reader.probe(file)) {
+            err << file << ": " << reader.errorString() << Qt::endl;
+            ++failed;
+            continue;
+        }
+        const qint64 elapsed = timer.nsecsElapsed() / 1000;
+
+        const WavReader::FormatChunk &format = reader.format();
+        out << file << '\t'
+            << (format.audioFormat == WavReader::PCM_FLOAT ? "float" : "int") << '\t'
+            << format.numChannels << '\t'
+            << format.sampleRate << '\t'
+            << format.bitsPerSample << '\t'
+            << format.byteRate << '\t'
+            << reader.frames() << '\t'
+            << reader.frames() * 1000000 / format.sampleRate << '\t'
+            << elapsed << '\n';
+    }
+
+    out.flush();
+    return failed > 0 ? 1 : 0;
+}
+
 int main(int argc, char *argv[])
 {
-    QApplication::setStyle("Fusion");
+    const bool headless = isHeadless(argc, argv);
+    if (!headless) {
+        QApplication::setStyle("Fusion");
+    }
 
-    QApplication app(argc, argv);
-    app.setApplicationName("TFA");
-    app.setApplicationVersion("1.0.1");
-    app.setOrganizationName("Unlimited Web Works");
-    app.setWindowIcon(QIcon(":/main.ico"));
+    QScopedPointer<QCoreApplication> app(headless ? new QCoreApplication(argc, argv) : new QApplication(argc, argv));
+    app->setApplicationName("TFA");
+    app->setApplicationVersion("1.0.1");
+    app->setOrganizationName("Unlimited Web Works");
+    if (!headless) {
+        QApplication::setWindowIcon(QIcon(":/main.ico"));
+    }
 
     QCommandLineParser parser;
     parser.setApplicationDescription("Программа для создания тайминга субтитров из аудио");
     parser.addHelpOption();
     parser.addVersionOption();
     parser.addPositionalArgument("audio", "WAV-файл");
-    parser.process(app);
+
+    const QCommandLineOption daemonOption("daemon", "Запустить демон, принимающий задания через локальный сокет");
+    const QCommandLineOption clientOption("client", "Отправить файлы демону и вывести ответы");
+    const QCommandLineOption probeOption("probe", "Вывести сведения о файлах, прочитав только заголовки");
+    const QCommandLineOption serverOption("server", "Имя локального сокета демона", "name", "TFA");
+    const QCommandLineOption outputOption({"o", "output"}, "Выходной файл (только для одного входного файла)", "file");
+    const QCommandLineOption thresholdOption("threshold", "Порог амплитуды, % или auto", "percent");
+    const QCommandLineOption minIntervalOption("min-interval", "Мин. интервал между фразами, мс", "msec");
+    const QCommandLineOption minLengthOption("min-length", "Мин. длительность фразы, мс", "msec");
+    const QCommandLineOption maxLengthOption("max-length", "Макс. длительность фразы, мс (0 - без ограничения)", "msec");
+    const QCommandLineOption perChannelOption("per-channel", "Искать фразы в каждом канале отдельно");
+    const QCommandLineOption readAheadOption("read-ahead", "Читать файл в отдельном потоке с очередью из N блоков (0 - в одном потоке)", "N");
+    const QCommandLineOption blockSizeOption("block-size", "Размер блока чтения, КиБ", "KiB");
+    const QCommandLineOption configOption("config", "Набор параметров порог_%|auto:интервал_мс:длительность_мс[:макс_длительность_мс]; "
+                                                    "можно указать несколько, все считаются за один проход", "t:i:l[:m]");
+    parser.addOptions({daemonOption, clientOption, probeOption, serverOption, outputOption,
+                       thresholdOption, minIntervalOption, minLengthOption, maxLengthOption, perChannelOption,
+                       readAheadOption, blockSizeOption, configOption});
+    parser.process(*app);
     const QStringList &args = parser.positionalArguments();
 
+    if (parser.isSet(probeOption)) {
+        if (args.isEmpty()) {
+            parser.showHelp(1);
+        }
+        return runProbe(args);
+    }
+
+    if (headless) {
+        Job::Params defaults = Job::defaultParams();
+        if (parser.isSet(thresholdOption)) {
+            // Наборы параметров всегда содержат свой порог
+            if (parser.isSet(configOption)) {
+                QTextStream(stderr) << "--threshold не действует на --config, укажите порог в наборе: 5:200:200 или auto:200:200" << Qt::endl;
+                return 1;
+            }
+
+            qreal threshold;
+            if (!Job::parseThreshold(parser.value(thresholdOption), &threshold)) {
+                QTextStream(stderr) << "Неправильный порог: " << parser.value(thresholdOption) << Qt::endl;
+                return 1;
+            }
+            defaults.autoThreshold = threshold == Job::AUTO_THRESHOLD;
+            if (!defaults.autoThreshold) {
+                defaults.detector.threshold = threshold;
+            }
+        }
+        if (parser.isSet(minIntervalOption)) {
+            defaults.detector.minInterval = parser.value(minIntervalOption).toInt();
+        }
+        if (parser.isSet(minLengthOption)) {
+            defaults.detector.minLength = parser.value(minLengthOption).toInt();
+        }
+        if (parser.isSet(maxLengthOption)) {
+            defaults.detector.maxLength = parser.value(maxLengthOption).toInt();
+        }
+        if (parser.isSet(perChannelOption)) {
+            defaults.perChannel = true;
+        }
+        if (parser.isSet(readAheadOption)) {
+            defaults.readAhead = parser.value(readAheadOption).toInt();
+        }
+        if (parser.isSet(blockSizeOption)) {
+            defaults.blockSize = parser.value(blockSizeOption).toInt();
+        }
+        for (const QString &value : parser.values(configOption)) {
+            Detector::Params config;
+            if (!Job::parseConfig(value, &config)) {
+                QTextStream(stderr) << "Неправильный набор параметров: " << value << Qt::endl;
+                return 1;
+            }
+            defaults.configs.append(config);
+        }
+
+        if (parser.isSet(daemonOption)) {
+            JobServer server(defaults);
+            if (!server.listen(parser.value(serverOption))) {
+                QTextStream(stderr) << server.errorString() << Qt::endl;
+                return 1;
+            }
+            return app->exec();
+        }
+
+        if (args.isEmpty()) {
+            parser.showHelp(1);
+        }
+
+        QList<Job::Params> jobs;
+        for (const QString &input : args) {
+            Job::Params params = defaults;
+            params.input = QFileInfo(input).absoluteFilePath();
+            params.output = parser.isSet(outputOption) && args.size() == 1
+                            ? QFileInfo(parser.value(outputOption)).absoluteFilePath()
+                            : Job::defaultOutput(params.input);
+            jobs.append(params);
+        }
+        return parser.isSet(clientOption) ? runClient(parser.value(serverOption), jobs) : runLocal(jobs);
+    }
+
     MainWindow window;
     window.processCommandLine(args);
     window.show();
     
-    return app.exec();
+    return app->exec();
 }
@@ -19,6 +19,7 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "srtwriter.h"
+#include "job.h"
 #include <QStyle>
 #include <QScreen>
 #include <QDragEnterEvent>
@@ -28,6 +29,8 @@
 #include <QDateTime>
 #include <QMenu>
 #include <QClipboard>
+#include <QMessageBox>
+#include <QtConcurrent>
 
 
 MainWindow::MainWindow(QWidget *parent) :
@@ -48,19 +51,29 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->tbInfo->verticalHeader()->setSectionResizeMode(QHeaderView::Stretch);
     ui->tbInfo->verticalHeader()->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(ui->tbInfo->verticalHeader(), &QHeaderView::customContextMenuRequested, this, &MainWindow::tbInfoCustomHeaderContextMenuRequested);
+    connect(&_loadWatcher, &QFutureWatcher<bool>::finished, this, &MainWindow::loadFinished);
 
     ui->spinThreshold->setValue(_settings.value(THRESHOLD_KEY, ui->spinThreshold->value()).toDouble());
     ui->spinMinInterval->setValue(_settings.value(MIN_INTERVAL_KEY, ui->spinMinInterval->value()).toInt());
     ui->spinMinLength->setValue(_settings.value(MIN_LENGTH_KEY, ui->spinMinLength->value()).toInt());
+    ui->spinMaxLength->setValue(_settings.value(MAX_LENGTH_KEY, ui->spinMaxLength->value()).toInt());
+    ui->chkAutoThreshold->setChecked(_settings.value(AUTO_THRESHOLD_KEY, ui->chkAutoThreshold->isChecked()).toBool());
+    ui->chkPerChannel->setChecked(_settings.value(PER_CHANNEL_KEY, ui->chkPerChannel->isChecked()).toBool());
 
     setGeometry(QStyle::alignedRect(Qt::LeftToRight, Qt::AlignCenter, size(), qApp->primaryScreen()->availableGeometry()));
 }
 
 MainWindow::~MainWindow()
 {
+    disconnect(&_loadWatcher, nullptr, this, nullptr);
+    _loadWatcher.waitForFinished();
+
     _settings.setValue(THRESHOLD_KEY, ui->spinThreshold->value());
     _settings.setValue(MIN_INTERVAL_KEY, ui->spinMinInterval->value());
     _settings.setValue(MIN_LENGTH_KEY, ui->spinMinLength->value());
+    _settings.setValue(MAX_LENGTH_KEY, ui->spinMaxLength->value());
+    _settings.setValue(AUTO_THRESHOLD_KEY, ui->chkAutoThreshold->isChecked());
+    _settings.setValue(PER_CHANNEL_KEY, ui->chkPerChannel->isChecked());
 
     delete ui;
 }
@@ -118,6 +131,24 @@ void MainWindow::on_btSave_clicked()
     saveFile(fileName);
 }
 
+void MainWindow::on_chkAutoThreshold_toggled(bool checked)
+{
+    ui->spinThreshold->setEnabled(!checked);
+    if (checked && !_loadWatcher.isRunning() && !_reader.isEmpty()) {
+        ui->spinThreshold->setValue(_reader.histogram().threshold() * 100.0);
+    }
+}
+
+void MainWindow::on_chkPerChannel_toggled(bool checked)
+{
+    Q_UNUSED(checked);
+
+    // Раскладка сэмплов выбирается при чтении, поэтому файл нужно перечитать
+    if (!_loadWatcher.isRunning() && !_reader.isEmpty()) {
+        openFile(_fileInfo.filePath());
+    }
+}
+
 void MainWindow::on_tbInfo_customContextMenuRequested(const QPoint &pos)
 {
     createContextMenu()->popup(ui->tbInfo->viewport()->mapToGlobal(pos));
@@ -149,11 +180,21 @@ void MainWindow::copyInfo()
 
 bool MainWindow::openFile(const QString &fileName)
 {
+    if (_loadWatcher.isRunning()) {
+        return false;
+    }
+
     ui->tbInfo->setEnabled(false);
     ui->btSave->setEnabled(false);
     ui->tbInfo->clearContents();
 
-    if (fileName.isEmpty() || !_reader.load(fileName)) {
+    if (fileName.isEmpty()) {
+        return false;
+    }
+
+    // Сведения берутся из заголовков и показываются до декодирования
+    if (!_reader.probe(fileName)) {
+        QMessageBox::critical(this, "Ошибка", _reader.errorString());
         return false;
     }
 
@@ -161,7 +202,7 @@ bool MainWindow::openFile(const QString &fileName)
 
     const WavReader::FormatChunk &format = _reader.format();
     QDateTime dt;
-    dt.setSecsSinceEpoch(static_cast<uint>(_reader.samples().size()) / format.sampleRate / format.numChannels + 61200u);
+    dt.setSecsSinceEpoch(_reader.frames() / format.sampleRate + 61200);
 
     ui->tbInfo->setItem(0, 0, new QTableWidgetItem(_fileInfo.fileName()));
     switch (format.audioFormat)
@@ -182,61 +223,76 @@ bool MainWindow::openFile(const QString &fileName)
     ui->tbInfo->setItem(4, 0, new QTableWidgetItem(QString::number(format.numChannels)));
     ui->tbInfo->setItem(5, 0, new QTableWidgetItem(QString("%1 КГц").arg(format.sampleRate * 0.001)));
     ui->tbInfo->setItem(6, 0, new QTableWidgetItem(QString("%1 бит").arg(format.bitsPerSample)));
-
-    _reader.toMono();
-
     ui->tbInfo->setEnabled(true);
-    ui->btSave->setEnabled(true);
+
+    // Декодирование долгих файлов не должно замораживать окно
+    setLoading(true);
+    const bool planar = ui->chkPerChannel->isChecked();
+    _loadWatcher.setFuture(QtConcurrent::run([this, fileName, planar]() {
+        if (!_reader.load(fileName, planar)) {
+            return false;
+        }
+        // В раздельном режиме каналы не сводятся в моно
+        if (!_reader.isPlanar()) {
+            _reader.toMono();
+        }
+        return true;
+    }));
 
     return true;
 }
 
+void MainWindow::setLoading(const bool loading)
+{
+    ui->btOpen->setEnabled(!loading);
+    ui->chkPerChannel->setEnabled(!loading);
+    setAcceptDrops(!loading);
+}
+
+void MainWindow::loadFinished()
+{
+    setLoading(false);
+
+    if (!_loadWatcher.result()) {
+        ui->tbInfo->setEnabled(false);
+        ui->tbInfo->clearContents();
+        QMessageBox::critical(this, "Ошибка", _reader.errorString());
+        return;
+    }
+
+    if (!_reader.warnings().isEmpty()) {
+        QMessageBox::warning(this, "Предупреждение", _reader.warnings().join('\n'));
+    }
+
+    // Гистограмма уровня собрана при чтении, второй проход не нужен
+    if (ui->chkAutoThreshold->isChecked()) {
+        ui->spinThreshold->setValue(_reader.histogram().threshold() * 100.0);
+    }
+
+    ui->btSave->setEnabled(true);
+}
+
 bool MainWindow::saveFile(const QString &fileName)
 {
-    const WavReader::SamplesList &samples = _reader.samples();
-//    const qreal threshold = *std::max_element(samples.constBegin(), samples.constEnd()) * ui->spinThreshold->value() * 0.01;
-    const qreal threshold = ui->spinThreshold->value() * 0.01;
-    const qreal samplesInMsec = _reader.format().sampleRate * 0.001;
-    const int minInterval = qRound(ui->spinMinInterval->value() * samplesInMsec);
-    const int minLength = ui->spinMinLength->value();
-    bool inPhrase = false;
-    int countdown = minInterval;
-    uint lastSeenTime = 0, num = 1;
-    SrtWriter::Phrase phrase;
+    const Detector::Params params = {
+        ui->spinThreshold->value() * 0.01,
+        ui->spinMinInterval->value(),
+        ui->spinMinLength->value(),
+        ui->spinMaxLength->value()
+    };
+    const SrtWriter::PhraseList phrases = Job::findPhrases(_reader, params);
+
     SrtWriter::SrtWriter writer;
-    for (int i = 0, len = samples.size(); i < len; ++i) {
-        if (qAbs(samples.at(i)) >= threshold) {
-            lastSeenTime = static_cast<uint>(qRound(i / samplesInMsec));
-            countdown = minInterval;
-
-            if (!inPhrase) {
-                inPhrase = true;
-                phrase.time.first = lastSeenTime;
-                phrase.text = QString::number(num);
-            }
-        } else if (inPhrase) {
-            if (countdown > 0) {
-                --countdown;
-            } else {
-                inPhrase = false;
-                phrase.time.second = lastSeenTime + 1;
-                if (static_cast<int>(phrase.time.second) - static_cast<int>(phrase.time.first) >= minLength)
-                {
-                    writer.addPhrase(phrase);
-                    ++num;
-                }
-            }
-        }
+    for (const SrtWriter::Phrase &phrase : std::as_const(phrases)) {
+        writer.addPhrase(phrase);
     }
 
-    if (inPhrase) {
-        phrase.time.second = lastSeenTime + 1;
-        if (static_cast<int>(phrase.time.second) - static_cast<int>(phrase.time.first) >= minLength) {
-            writer.addPhrase(phrase);
-        }
+    if (!writer.save(fileName)) {
+        QMessageBox::critical(this, "Ошибка", writer.errorString());
+        return false;
     }
 
-    return writer.save(fileName);
+    return true;
 }
 
 QString MainWindow::urlToPath(const QUrl &url)
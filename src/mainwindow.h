@@ -23,6 +23,7 @@
 #include <QMainWindow>
 #include <QSettings>
 #include <QFileInfo>
+#include <QFutureWatcher>
 
 namespace Ui {
     class MainWindow;
@@ -40,25 +41,33 @@ public:
 private slots:
     void on_btOpen_clicked();
     void on_btSave_clicked();
+    void on_chkAutoThreshold_toggled(bool checked);
+    void on_chkPerChannel_toggled(bool checked);
     void on_tbInfo_customContextMenuRequested(const QPoint &pos);
     void tbInfoCustomHeaderContextMenuRequested(const QPoint &pos);
     void copyInfo();
+    void loadFinished();
 
 private:
-    const QString DEFAULT_DIR_KEY  = "DefaultDir",
-                  THRESHOLD_KEY    = "Threshold",
-                  MIN_INTERVAL_KEY = "MinInterval",
-                  MIN_LENGTH_KEY   = "MinLength";
+    const QString DEFAULT_DIR_KEY    = "DefaultDir",
+                  THRESHOLD_KEY      = "Threshold",
+                  MIN_INTERVAL_KEY   = "MinInterval",
+                  MIN_LENGTH_KEY     = "MinLength",
+                  MAX_LENGTH_KEY     = "MaxLength",
+                  AUTO_THRESHOLD_KEY = "AutoThreshold",
+                  PER_CHANNEL_KEY    = "PerChannel";
 
     Ui::MainWindow *ui;
     QSettings _settings;
     QFileInfo _fileInfo;
     WavReader::WavReader _reader;
+    QFutureWatcher<bool> _loadWatcher; // декодирование идёт в фоне, пока _reader занят - файл не трогаем
 
     void dragEnterEvent(QDragEnterEvent *event);
     void dropEvent(QDropEvent *event);
     QMenu* createContextMenu();
     bool openFile(const QString &fileName);
+    void setLoading(bool loading);
     bool saveFile(const QString &fileName);
     QString urlToPath(const QUrl &url);
 };
@@ -0,0 +1,109 @@
+/*
+ * This file is part of TFA.
+ * Copyright (C) 2013-2025  Andrey Efremov <duxus@yandex.ru>
+ *
+ * TFA is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TFA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TFA.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "rangemin.h"
+#include <QtAlgorithms>
+
+namespace RangeMin
+{
+RangeMin::RangeMin(const QList<float> &values) :
+    _values(values)
+{
+    const int count = _values.size();
+    _masks.resize(count);
+
+    // Маски: для каждой позиции - стек позиций блока с неубывающими значениями
+    for (int start = 0; start < count; start += BLOCK) {
+        quint32 stack = 0;
+        for (int i = start, end = qMin(start + BLOCK, count); i < end; ++i) {
+            while (stack != 0) {
+                const int top = 31 - static_cast<int>(qCountLeadingZeroBits(stack));
+                if (_values.at(start + top) <= _values.at(i)) {
+                    break;
+                }
+                stack &= ~(1u << top);
+            }
+            stack |= 1u << (i - start);
+            _masks[i] = stack;
+        }
+    }
+
+    // Разреженная таблица по минимумам блоков
+    const int blocks = (count + BLOCK - 1) / BLOCK;
+    if (blocks == 0) {
+        return;
+    }
+
+    QList<int> level(blocks);
+    for (int b = 0; b < blocks; ++b) {
+        level[b] = inBlock(b * BLOCK, qMin((b + 1) * BLOCK, count) - 1);
+    }
+    _table.append(level);
+
+    for (int width = 1; width * 2 <= blocks; width *= 2) {
+        const QList<int> &previous = _table.last();
+        QList<int> next(blocks - width * 2 + 1);
+        for (int b = 0; b < next.size(); ++b) {
+            next[b] = better(previous.at(b), previous.at(b + width));
+        }
+        _table.append(next);
+    }
+}
+
+int RangeMin::size() const
+{
+    return _values.size();
+}
+
+int RangeMin::better(const int a, const int b) const
+{
+    return _values.at(b) < _values.at(a) ? b : a;
+}
+
+int RangeMin::inBlock(const int left, const int right) const
+{
+    const int start = left - left % BLOCK;
+    return start + static_cast<int>(qCountTrailingZeroBits(_masks.at(right) & (~0u << (left - start))));
+}
+
+int RangeMin::indexOfMin(int left, int right) const
+{
+    if (_values.isEmpty()) {
+        return -1;
+    }
+    left = qBound(0, left, size() - 1);
+    right = qBound(left, right, size() - 1);
+
+    const int leftBlock = left / BLOCK,
+              rightBlock = right / BLOCK;
+    if (leftBlock == rightBlock) {
+        return inBlock(left, right);
+    }
+
+    // При равных значениях остаётся самая левая позиция
+    int result = inBlock(left, (leftBlock + 1) * BLOCK - 1);
+    if (rightBlock - leftBlock > 1) {
+        const int first = leftBlock + 1,
+                  last = rightBlock - 1,
+                  level = 31 - static_cast<int>(qCountLeadingZeroBits(static_cast<quint32>(last - first + 1)));
+        const QList<int> &row = _table.at(level);
+        result = better(result, better(row.at(first), row.at(last - (1 << level) + 1)));
+    }
+    return better(result, inBlock(rightBlock * BLOCK, right));
+}
+}
@@ -0,0 +1,48 @@
+/*
+ * This file is part of TFA.
+ * Copyright (C) 2013-2025  Andrey Efremov <duxus@yandex.ru>
+ *
+ * TFA is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TFA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TFA.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RANGEMIN_H
+#define RANGEMIN_H
+
+#include <QList>
+
+namespace RangeMin
+{
+// Поиск позиции минимума на отрезке за O(1) при O(n) памяти:
+// разреженная таблица по минимумам блоков из 32 элементов,
+// внутри блока - битовые маски монотонного стека.
+class RangeMin
+{
+    static constexpr int BLOCK = 32;
+
+    QList<float> _values;
+    QList<quint32> _masks;
+    QList<QList<int>> _table;
+
+    int inBlock(int left, int right) const;
+    int better(int a, int b) const;
+
+public:
+    explicit RangeMin(const QList<float> &values = QList<float>());
+
+    int size() const;
+    int indexOfMin(int left, int right) const;
+};
+}
+
+#endif // RANGEMIN_H
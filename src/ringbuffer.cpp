@@ -0,0 +1,132 @@
+/*
+ * This file is part of TFA.
+ * Copyright (C) 2013-2025  Andrey Efremov <duxus@yandex.ru>
+ *
+ * TFA is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TFA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TFA.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ringbuffer.h"
+#include <QThread>
+#include <QElapsedTimer>
+
+namespace RingBuffer
+{
+// Сначала короткое активное ожидание, затем уступаем процессор, затем спим:
+// при медленном диске простаивающая сторона не занимает ядро
+template<typename Ready>
+static void wait(const Ready &ready, qint64 *stall)
+{
+    if (ready()) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; !ready(); ++i) {
+        if (i < 64) {
+            continue;
+        }
+        if (i < 128) {
+            QThread::yieldCurrentThread();
+        } else {
+            QThread::usleep(50);
+        }
+    }
+    *stall += timer.nsecsElapsed();
+}
+
+RingBuffer::RingBuffer(const int depth, const qint64 blockSize) :
+    _blockSize(qMax<qint64>(blockSize, 1)),
+    _head(0),
+    _tail(0),
+    _closed(false),
+    _writerStall(0),
+    _readerStall(0)
+{
+    for (int i = 0, count = qMax(depth, 1); i < count; ++i) {
+        _blocks.append(static_cast<char*>(qMallocAligned(static_cast<size_t>(_blockSize), ALIGNMENT)));
+        Q_CHECK_PTR(_blocks.last());
+    }
+    _sizes.fill(0, _blocks.size());
+}
+
+RingBuffer::~RingBuffer()
+{
+    for (char *block : std::as_const(_blocks)) {
+        qFreeAligned(block);
+    }
+}
+
+int RingBuffer::depth() const
+{
+    return _blocks.size();
+}
+
+qint64 RingBuffer::blockSize() const
+{
+    return _blockSize;
+}
+
+char *RingBuffer::beginWrite()
+{
+    const quint64 head = _head.load(std::memory_order_relaxed);
+    const quint64 depth = static_cast<quint64>(_blocks.size());
+    wait([&] { return head - _tail.load(std::memory_order_acquire) < depth; }, &_writerStall);
+    return _blocks.at(static_cast<int>(head % depth));
+}
+
+void RingBuffer::endWrite(const qint64 size)
+{
+    const quint64 head = _head.load(std::memory_order_relaxed);
+    _sizes[static_cast<int>(head % static_cast<quint64>(_blocks.size()))] = size;
+    _head.store(head + 1, std::memory_order_release);
+}
+
+void RingBuffer::close()
+{
+    _closed.store(true, std::memory_order_release);
+}
+
+const char *RingBuffer::beginRead(qint64 *size)
+{
+    const quint64 tail = _tail.load(std::memory_order_relaxed);
+    wait([&] {
+        return _head.load(std::memory_order_acquire) != tail || _closed.load(std::memory_order_acquire);
+    }, &_readerStall);
+
+    // close() вызывается после последнего endWrite(), поэтому повторная проверка надёжна
+    if (_head.load(std::memory_order_acquire) == tail) {
+        return nullptr;
+    }
+
+    const int index = static_cast<int>(tail % static_cast<quint64>(_blocks.size()));
+    *size = _sizes.at(index);
+    return _blocks.at(index);
+}
+
+void RingBuffer::endRead()
+{
+    _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+qint64 RingBuffer::writerStall() const
+{
+    return _writerStall;
+}
+
+qint64 RingBuffer::readerStall() const
+{
+    return _readerStall;
+}
+}
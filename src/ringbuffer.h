@@ -0,0 +1,69 @@
+/*
+ * This file is part of TFA.
+ * Copyright (C) 2013-2025  Andrey Efremov <duxus@yandex.ru>
+ *
+ * TFA is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TFA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TFA.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <QList>
+#include <atomic>
+
+namespace RingBuffer
+{
+// Кольцо выровненных блоков без блокировок для одного писателя и одного читателя.
+// Писатель заполняет блок между beginWrite() и endWrite(), читатель разбирает его
+// между beginRead() и endRead(); ожидание свободного или заполненного блока
+// учитывается в счётчиках простоя каждой стороны.
+class RingBuffer
+{
+    static constexpr qint64 ALIGNMENT = 4096;
+
+    QList<char*> _blocks;
+    QList<qint64> _sizes;
+    qint64 _blockSize;
+    // Счётчики на разных линиях кэша, чтобы стороны не мешали друг другу
+    alignas(64) std::atomic<quint64> _head; // заполнено блоков, пишет только писатель
+    alignas(64) std::atomic<quint64> _tail; // разобрано блоков, пишет только читатель
+    std::atomic<bool> _closed;
+    qint64 _writerStall; // нс
+    qint64 _readerStall; // нс
+
+    Q_DISABLE_COPY(RingBuffer)
+
+public:
+    explicit RingBuffer(int depth, qint64 blockSize);
+    ~RingBuffer();
+
+    int depth() const;
+    qint64 blockSize() const;
+
+    // Писатель
+    char *beginWrite();
+    void endWrite(qint64 size);
+    void close();
+
+    // Читатель; nullptr - писатель закончил и все блоки разобраны
+    const char *beginRead(qint64 *size);
+    void endRead();
+
+    // Читать после завершения обеих сторон
+    qint64 writerStall() const;
+    qint64 readerStall() const;
+};
+}
+
+#endif // RINGBUFFER_H
@@ -17,7 +17,6 @@
  */
 
 #include "srtwriter.h"
-#include <QMessageBox>
 #include <QFile>
 #include <QTextStream>
 #include <QDateTime>
@@ -38,9 +37,11 @@ void SrtWriter::addPhrase(const Phrase &phrase)
 
 bool SrtWriter::save(const QString &fileName)
 {
+    _errorString.clear();
+
     QFile fout(fileName);
     if (!fout.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::critical(nullptr, "Ошибка", "Не могу открыть файл для записи.");
+        _errorString = "Не могу открыть файл для записи.";
         return false;
     }
     QTextStream out(&fout);
@@ -56,4 +57,9 @@ bool SrtWriter::save(const QString &fileName)
     fout.close();
     return true;
 }
+
+const QString &SrtWriter::errorString() const
+{
+    return _errorString;
+}
 }
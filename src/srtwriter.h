@@ -36,10 +36,12 @@ typedef QList<Phrase> PhraseList;
 class SrtWriter
 {
     PhraseList _phrases;
+    QString _errorString;
 
 public:
     void addPhrase(const Phrase &phrase);
     bool save(const QString &fileName);
+    const QString &errorString() const;
 };
 }
 
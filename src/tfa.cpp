@@ -0,0 +1,274 @@
+/*
+ * This file is part of TFA.
+ * Copyright (C) 2013-2025  Andrey Efremov <duxus@yandex.ru>
+ *
+ * TFA is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TFA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TFA.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "tfa.h"
+#include "wavreader.h"
+#include "detector.h"
+#include <QString>
+
+namespace
+{
+// Чтение одного сэмпла из буфера вызывающей стороны
+template <typename T>
+struct Sample
+{
+    static constexpr size_t size = sizeof(T);
+
+    static qreal read(const char *data)
+    {
+        return WavReader::toReal(WavReader::readSample<T>(data));
+    }
+};
+
+struct Int24Sample
+{
+    static constexpr size_t size = 3;
+
+    static qreal read(const char *data)
+    {
+        return WavReader::int24ToReal(reinterpret_cast<const quint8*>(data));
+    }
+};
+
+// Каналы сводятся в моно усреднением, как WavReader::mixdown(), без промежуточного буфера
+template <typename S>
+void feedInterleaved(Detector::Detector &detector, const void *data, const size_t frames, const int channels)
+{
+    const char *ptr = static_cast<const char*>(data);
+    for (size_t i = 0; i < frames; ++i) {
+        qreal sum = 0.0;
+        for (int c = 0; c < channels; ++c, ptr += S::size) {
+            sum += S::read(ptr);
+        }
+        detector.process(sum / channels);
+    }
+}
+
+template <typename S>
+void feedPlanar(Detector::Detector &detector, const void *const *planes, const size_t frames, const int channels)
+{
+    for (size_t i = 0, offset = 0; i < frames; ++i, offset += S::size) {
+        qreal sum = 0.0;
+        for (int c = 0; c < channels; ++c) {
+            sum += S::read(static_cast<const char*>(planes[c]) + offset);
+        }
+        detector.process(sum / channels);
+    }
+}
+
+// Вызывает feed с типом сэмпла, соответствующим формату
+template <typename Feed>
+bool dispatch(const int format, Feed feed)
+{
+    switch (format)
+    {
+    case TFA_FORMAT_U8:
+        feed(Sample<quint8>());
+        return true;
+
+    case TFA_FORMAT_S16:
+        feed(Sample<qint16>());
+        return true;
+
+    case TFA_FORMAT_S24:
+        feed(Int24Sample());
+        return true;
+
+    case TFA_FORMAT_S32:
+        feed(Sample<qint32>());
+        return true;
+
+    case TFA_FORMAT_F32:
+        feed(Sample<float>());
+        return true;
+
+    case TFA_FORMAT_F64:
+        feed(Sample<double>());
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+Detector::Params toParams(const tfa_params *params)
+{
+    tfa_params defaults;
+    if (params == nullptr) {
+        tfa_default_params(&defaults);
+        params = &defaults;
+    }
+    return {params->threshold, params->min_interval, params->min_length, 0};
+}
+
+int output(const Detector::IntervalList &result, tfa_interval *intervals, const size_t capacity, size_t *count)
+{
+    const size_t size = static_cast<size_t>(result.size());
+    if (count != nullptr) {
+        *count = size;
+    }
+
+    for (size_t i = 0; i < size && i < capacity; ++i) {
+        intervals[i].start = result.at(i).first;
+        intervals[i].end = result.at(i).second;
+    }
+
+    return size > capacity ? TFA_ERROR_SMALL_ARRAY : TFA_OK;
+}
+
+bool isValid(const int channels, const unsigned int sampleRate, tfa_interval *intervals, const size_t capacity)
+{
+    return channels > 0 && sampleRate > 0 && (intervals != nullptr || capacity == 0);
+}
+}
+
+extern "C"
+{
+int tfa_version(void)
+{
+    return TFA_API_VERSION;
+}
+
+void tfa_default_params(tfa_params *params)
+{
+    if (params == nullptr) {
+        return;
+    }
+
+    params->threshold = 0.05;
+    params->min_interval = 200;
+    params->min_length = 200;
+}
+
+int tfa_detect_interleaved(const void *data, const size_t frames, const int channels, const int format,
+                           const unsigned int sample_rate, const tfa_params *params,
+                           tfa_interval *intervals, const size_t capacity, size_t *count)
+{
+    if ((data == nullptr && frames > 0) || !isValid(channels, sample_rate, intervals, capacity)) {
+        return TFA_ERROR_ARGUMENT;
+    }
+
+    // Исключения не должны выходить за границу C ABI
+    try {
+        Detector::Detector detector(toParams(params), sample_rate);
+        const bool known = dispatch(format, [&](auto sample) {
+            feedInterleaved<decltype(sample)>(detector, data, frames, channels);
+        });
+        if (!known) {
+            return TFA_ERROR_ARGUMENT;
+        }
+        detector.finish();
+        return output(detector.intervals(), intervals, capacity, count);
+    } catch (...) {
+        return TFA_ERROR_INTERNAL;
+    }
+}
+
+int tfa_detect_planar(const void *const *planes, const size_t frames, const int channels, const int format,
+                      const unsigned int sample_rate, const tfa_params *params,
+                      tfa_interval *intervals, const size_t capacity, size_t *count)
+{
+    if (planes == nullptr || !isValid(channels, sample_rate, intervals, capacity)) {
+        return TFA_ERROR_ARGUMENT;
+    }
+    for (int c = 0; c < channels; ++c) {
+        if (planes[c] == nullptr && frames > 0) {
+            return TFA_ERROR_ARGUMENT;
+        }
+    }
+
+    try {
+        Detector::Detector detector(toParams(params), sample_rate);
+        const bool known = dispatch(format, [&](auto sample) {
+            feedPlanar<decltype(sample)>(detector, planes, frames, channels);
+        });
+        if (!known) {
+            return TFA_ERROR_ARGUMENT;
+        }
+        detector.finish();
+        return output(detector.intervals(), intervals, capacity, count);
+    } catch (...) {
+        return TFA_ERROR_INTERNAL;
+    }
+}
+
+int tfa_probe_file(const char *path, tfa_file_info *info)
+{
+    if (path == nullptr || info == nullptr) {
+        return TFA_ERROR_ARGUMENT;
+    }
+
+    try {
+        WavReader::WavReader reader;
+        if (!reader.probe(QString::fromUtf8(path))) {
+            return TFA_ERROR_FILE;
+        }
+
+        const WavReader::FormatChunk &format = reader.format();
+        switch (format.bitsPerSample / 8)
+        {
+        case 1:
+            info->format = TFA_FORMAT_U8;
+            break;
+
+        case 2:
+            info->format = TFA_FORMAT_S16;
+            break;
+
+        case 3:
+            info->format = TFA_FORMAT_S24;
+            break;
+
+        case 4:
+            info->format = format.audioFormat == WavReader::PCM_FLOAT ? TFA_FORMAT_F32 : TFA_FORMAT_S32;
+            break;
+
+        default:
+            info->format = TFA_FORMAT_F64;
+        }
+        info->channels = format.numChannels;
+        info->sample_rate = format.sampleRate;
+        info->frames = static_cast<unsigned long long>(reader.frames());
+        return TFA_OK;
+    } catch (...) {
+        return TFA_ERROR_INTERNAL;
+    }
+}
+
+int tfa_detect_file(const char *path, const tfa_params *params,
+                    tfa_interval *intervals, const size_t capacity, size_t *count)
+{
+    if (path == nullptr || (intervals == nullptr && capacity > 0)) {
+        return TFA_ERROR_ARGUMENT;
+    }
+
+    try {
+        WavReader::WavReader reader;
+        if (!reader.load(QString::fromUtf8(path))) {
+            return TFA_ERROR_FILE;
+        }
+
+        // То же сведение в моно, что и в программе
+        reader.toMono();
+        const Detector::IntervalList result = Detector::detect(reader.samples(), reader.format().sampleRate, toParams(params));
+        return output(result, intervals, capacity, count);
+    } catch (...) {
+        return TFA_ERROR_INTERNAL;
+    }
+}
+}
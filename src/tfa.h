@@ -0,0 +1,114 @@
+/*
+ * This file is part of TFA.
+ * Copyright (C) 2013-2025  Andrey Efremov <duxus@yandex.ru>
+ *
+ * TFA is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TFA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with TFA.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TFA_H
+#define TFA_H
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#  if defined(TFA_LIBRARY)
+#    define TFA_EXPORT __declspec(dllexport)
+#  else
+#    define TFA_EXPORT __declspec(dllimport)
+#  endif
+#else
+#  define TFA_EXPORT __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TFA_API_VERSION 1
+
+/* Форматы сэмплов, всегда в порядке байт платформы */
+enum
+{
+    TFA_FORMAT_U8  = 0, /* uint8, 128 означает 0 */
+    TFA_FORMAT_S16 = 1,
+    TFA_FORMAT_S24 = 2, /* упакованные 3 байта */
+    TFA_FORMAT_S32 = 3,
+    TFA_FORMAT_F32 = 4,
+    TFA_FORMAT_F64 = 5
+};
+
+/* Коды возврата */
+enum
+{
+    TFA_OK                = 0,
+    TFA_ERROR_ARGUMENT    = 1,
+    TFA_ERROR_SMALL_ARRAY = 2, /* в *count записано требуемое количество */
+    TFA_ERROR_FILE        = 3,
+    TFA_ERROR_INTERNAL    = 4
+};
+
+typedef struct tfa_params
+{
+    double threshold;  /* порог амплитуды, 0..1 */
+    int min_interval;  /* мин. интервал между фразами, мс */
+    int min_length;    /* мин. длительность фразы, мс */
+} tfa_params;
+
+typedef struct tfa_file_info
+{
+    int format;                /* TFA_FORMAT_* */
+    int channels;
+    unsigned int sample_rate;
+    unsigned long long frames; /* точное количество кадров */
+} tfa_file_info;
+
+typedef struct tfa_interval
+{
+    unsigned int start; /* мс */
+    unsigned int end;   /* мс */
+} tfa_interval;
+
+/* Версия ABI, совпадает с TFA_API_VERSION, с которой собрана библиотека */
+TFA_EXPORT int tfa_version(void);
+
+/* Параметры по умолчанию, как в программе TFA */
+TFA_EXPORT void tfa_default_params(tfa_params *params);
+
+/*
+ * Поиск фраз в чередующихся сэмплах: data содержит frames * channels сэмплов.
+ * Буфер не копируется, каналы сводятся в моно на лету.
+ * Интервалы записываются в массив вызывающей стороны ёмкостью capacity,
+ * в *count возвращается их общее количество.
+ */
+TFA_EXPORT int tfa_detect_interleaved(const void *data, size_t frames, int channels, int format,
+                                      unsigned int sample_rate, const tfa_params *params,
+                                      tfa_interval *intervals, size_t capacity, size_t *count);
+
+/* То же для раздельных каналов: planes[channels], в каждом frames сэмплов */
+TFA_EXPORT int tfa_detect_planar(const void *const *planes, size_t frames, int channels, int format,
+                                 unsigned int sample_rate, const tfa_params *params,
+                                 tfa_interval *intervals, size_t capacity, size_t *count);
+
+/* Сведения о WAV-файле (путь в UTF-8) только по заголовкам, без чтения данных */
+TFA_EXPORT int tfa_probe_file(const char *path, tfa_file_info *info);
+
+/* Поиск фраз в WAV-файле (путь в UTF-8) */
+TFA_EXPORT int tfa_detect_file(const char *path, const tfa_params *params,
+                               tfa_interval *intervals, size_t capacity, size_t *count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TFA_H */
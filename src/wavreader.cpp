@@ -17,86 +17,273 @@
  */
 
 #include "wavreader.h"
-#include <QMessageBox>
+#include "ringbuffer.h"
 #include <QFile>
+#include <QThread>
+#include <QScopedPointer>
+#include <cstring>
 
 namespace WavReader
 {
-WavReader::WavReader()
+WavReader::WavReader() :
+    _planar(false),
+    _channel(0),
+    _readAhead(0),
+    _blockSize(DEFAULT_BLOCK_SIZE)
 {
     clear();
 }
 
-WavReader::WavReader(const QString &fileName)
+WavReader::WavReader(const QString &fileName, const bool planar) :
+    _readAhead(0),
+    _blockSize(DEFAULT_BLOCK_SIZE)
 {
-    load(fileName);
+    load(fileName, planar);
 }
 
 void WavReader::clear()
 {
     std::memset(&_format, 0, sizeof(FormatChunk));
+    // Списки каналов не удаляются, а очищаются: их память достанется следующему файлу
     _samples.clear();
+    for (SamplesList &channel : _channels) {
+        channel.clear();
+    }
+    _channel = 0;
+    _mixed = 0;
+    _histogram.reset(1);
+    _histograms.clear();
+    _dataOffset = 0;
+    _dataSize = 0;
+    _frames = 0;
+    _stats = {0, 0, 0};
 }
 
-bool WavReader::load(const QString &fileName)
+void WavReader::release(const qint64 keepSamples)
 {
     clear();
 
-    // Открытие файла
-    QFile fin(fileName);
-    if (!fin.open(QIODevice::ReadOnly)) {
-        QMessageBox::critical(nullptr, "Ошибка", "Не могу открыть файл для чтения.");
-        return false;
+    qint64 capacity = _samples.capacity() + _mixBuffer.capacity();
+    for (const SamplesList &channel : std::as_const(_channels)) {
+        capacity += channel.capacity();
+    }
+    if (capacity > keepSamples) {
+        _samples = SamplesList();
+        _mixBuffer = SamplesList();
+        _channels.clear();
+    }
+}
+
+void WavReader::setReadAhead(const int depth, const qint64 blockSize)
+{
+    _blockSize = qBound<qint64>(1, blockSize, MAX_BLOCK_SIZE);
+    _readAhead = qBound(0, depth, qMin<int>(MAX_READ_AHEAD, MAX_RING_SIZE / _blockSize));
+}
+
+void WavReader::appendSample(const qreal sample)
+{
+    if (!_planar) {
+        _samples.append(sample);
+        return;
+    }
+
+    // Раскладываем чередующиеся сэмплы по каналам прямо при чтении
+    _channels[_channel].append(sample);
+    if (++_channel == _channels.size()) {
+        _channel = 0;
+    }
+}
+
+void WavReader::decode(const char *data, const qint64 size)
+{
+    if (!_planar) {
+        decodeSamples(data, size);
+
+        // Уровень считается по тому же сведению в моно, которое потом получит детектор (toMono()).
+        // Неполный кадр в конце блока дождётся следующего блока
+        const int numChannels = _format.numChannels;
+        const qsizetype frames = (_samples.size() - _mixed) / numChannels;
+        if (numChannels == 1) {
+            _histograms[0].add(_samples.constData() + _mixed, frames);
+        } else {
+            _mixBuffer.resize(frames);
+            for (qsizetype i = 0; i < frames; ++i) {
+                _mixBuffer[i] = mixdown(_samples.constData() + _mixed + i * numChannels, numChannels);
+            }
+            _histograms[0].add(_mixBuffer.constData(), frames);
+        }
+        _mixed += frames * numChannels;
+        return;
+    }
+
+    QList<qsizetype> starts;
+    for (const SamplesList &channel : std::as_const(_channels)) {
+        starts.append(channel.size());
+    }
+
+    decodeSamples(data, size);
+
+    // Уровень каждого канала считается по непрерывному участку, добавленному этим блоком
+    for (int i = 0; i < starts.size(); ++i) {
+        const SamplesList &channel = _channels.at(i);
+        _histograms[i].add(channel.constData() + starts.at(i), channel.size() - starts.at(i));
+    }
+}
+
+void WavReader::decodeSamples(const char *data, const qint64 size)
+{
+    // Формат и размер сэмпла уже проверены в readHeaders()
+    const char *end = data + size;
+    const qint64 sampleSize = _format.bitsPerSample / 8;
+    if (_format.audioFormat == PCM_FLOAT) {
+        if (sampleSize == sizeof(float)) {
+            for (; data < end; data += sizeof(float)) {
+                appendSample(toReal(readSample<float>(data)));
+            }
+        } else {
+            for (; data < end; data += sizeof(double)) {
+                appendSample(toReal(readSample<double>(data)));
+            }
+        }
+        return;
+    }
+
+    switch (sampleSize)
+    {
+    case sizeof(quint8): // uint8
+        for (; data < end; data += sizeof(quint8)) {
+            appendSample(toReal(readSample<quint8>(data)));
+        }
+        break;
+
+    case sizeof(qint16): // int16
+        for (; data < end; data += sizeof(qint16)) {
+            appendSample(toReal(readSample<qint16>(data)));
+        }
+        break;
+
+    case sizeof(qint32) - 1: // int24
+        for (; data < end; data += sizeof(qint32) - 1) {
+            appendSample(int24ToReal(reinterpret_cast<const quint8*>(data)));
+        }
+        break;
+
+    case sizeof(qint32): // int32
+        for (; data < end; data += sizeof(qint32)) {
+            appendSample(toReal(readSample<qint32>(data)));
+        }
+        break;
+    }
+}
+
+qint64 WavReader::alignedBlockSize() const
+{
+    // Блок - целое число сэмплов, чтобы сэмпл не разрывался между блоками
+    const qint64 sampleSize = _format.bitsPerSample / 8;
+    return qMax(_blockSize - _blockSize % sampleSize, sampleSize);
+}
+
+qint64 WavReader::readBlocks(QFile &fin, const qint64 chunkEnd)
+{
+    const qint64 sampleSize = _format.bitsPerSample / 8;
+    QByteArray block(alignedBlockSize(), Qt::Uninitialized);
+    qint64 size, total = 0;
+    while ((size = qMin<qint64>(block.size(), chunkEnd - fin.pos())) > 0) {
+        const qint64 read = fin.read(block.data(), size);
+        if (read <= 0) {
+            break;
+        }
+        total += read;
+        decode(block.constData(), read - read % sampleSize);
+        if (read < size) {
+            break;
+        }
     }
+    return total;
+}
 
+qint64 WavReader::readAhead(QFile &fin, const qint64 chunkEnd)
+{
+    const qint64 sampleSize = _format.bitsPerSample / 8;
+    const qint64 blockSize = alignedBlockSize();
+    RingBuffer::RingBuffer ring(_readAhead, blockSize);
+
+    // Пока поток чтения ждёт диск, этот поток декодирует уже прочитанные блоки
+    qint64 total = 0; // пишет только поток чтения, читается после wait()
+    QScopedPointer<QThread> reader(QThread::create([&fin, &ring, &total, chunkEnd, blockSize] {
+        qint64 size;
+        while ((size = qMin(blockSize, chunkEnd - fin.pos())) > 0) {
+            char *block = ring.beginWrite();
+            const qint64 read = fin.read(block, size);
+            if (read <= 0) {
+                break;
+            }
+            total += read;
+            ring.endWrite(read);
+            if (read < size) {
+                break;
+            }
+        }
+        ring.close();
+    }));
+    reader->start();
+
+    qint64 size;
+    while (const char *block = ring.beginRead(&size)) {
+        decode(block, size - size % sampleSize);
+        ring.endRead();
+        ++_stats.blocks;
+    }
+    reader->wait();
+
+    _stats.readerStall = ring.writerStall() / 1000;
+    _stats.decoderStall = ring.readerStall() / 1000;
+    return total;
+}
+
+bool WavReader::readHeaders(QFile &fin)
+{
     // Чтение заголовка
     ChunkHeader header;
     if (fin.read(reinterpret_cast<char*>(&header), sizeof(ChunkHeader)) != sizeof(ChunkHeader)) {
-        fin.close();
-        QMessageBox::critical(nullptr, "Ошибка", "Ошибка чтения.");
+        _errorString = "Ошибка чтения.";
         return false;
     }
 
     if (ID_RIFF != header.id) {
-        fin.close();
-        QMessageBox::critical(nullptr, "Ошибка", "Не найден заголовок RIFF.");
+        _errorString = "Не найден заголовок RIFF.";
         return false;
     }
 
     const qint64 fileSize = sizeof(ChunkHeader) + header.size;
     if (fin.size() < fileSize) {
-        fin.close();
-        QMessageBox::critical(nullptr, "Ошибка", "Реальный размер файла меньше, чем указанный в заголовке.");
+        _errorString = "Реальный размер файла меньше, чем указанный в заголовке.";
         return false;
     }
 
     quint32 fileFormat;
     if (fin.read(reinterpret_cast<char*>(&fileFormat), sizeof(quint32)) != sizeof(quint32)) {
-        fin.close();
-        QMessageBox::critical(nullptr, "Ошибка", "Ошибка чтения.");
+        _errorString = "Ошибка чтения.";
         return false;
     }
 
     if (FMT_WAVE != fileFormat) {
-        fin.close();
-        QMessageBox::critical(nullptr, "Ошибка", "Файл RIFF не является файлом WAV.");
+        _errorString = "Файл RIFF не является файлом WAV.";
         return false;
     }
 
-    // Чтение секций
+    // Чтение секций: читаются только заголовки, данные пропускаются
     bool hasFormat = false,
          hasData = false;
     qint64 chunkEnd = 0;
     while (!fin.atEnd() && fin.pos() < fileSize) {
         if (fin.read(reinterpret_cast<char*>(&header), sizeof(ChunkHeader)) != sizeof(ChunkHeader)) {
-            fin.close();
-            QMessageBox::critical(nullptr, "Ошибка", "Ошибка чтения.");
+            _errorString = "Ошибка чтения.";
             return false;
         }
 
         if (fin.bytesAvailable() < header.size) {
-            fin.close();
-            QMessageBox::critical(nullptr, "Ошибка", "Указанный размер секции больше, чем осталось до конца файла.");
+            _errorString = "Указанный размер секции больше, чем осталось до конца файла.";
             return false;
         }
         chunkEnd = fin.pos() + header.size;
@@ -106,14 +293,12 @@ bool WavReader::load(const QString &fileName)
         {
         case ID_FORMAT:
             if (hasFormat) {
-                QMessageBox::warning(nullptr, "Предупреждение", "Повторяющаяся секция FORMAT");
+                _warnings.append("Повторяющаяся секция FORMAT");
                 break;
             }
 
             if (fin.read(reinterpret_cast<char*>(&_format), sizeof(FormatChunk)) != sizeof(FormatChunk)) {
-                fin.close();
-                clear();
-                QMessageBox::critical(nullptr, "Ошибка", "Ошибка чтения.");
+                _errorString = "Ошибка чтения.";
                 return false;
             }
             hasFormat = true;
@@ -121,162 +306,162 @@ bool WavReader::load(const QString &fileName)
 
         case ID_DATA:
             if (hasData) {
-                QMessageBox::warning(nullptr, "Предупреждение", "Повторяющаяся секция DATA");
+                _warnings.append("Повторяющаяся секция DATA");
                 break;
             }
 
             if (!hasFormat) {
-                fin.close();
-                clear();
-                QMessageBox::critical(nullptr, "Ошибка", "Секция FORMAT не найдена.");
+                _errorString = "Секция FORMAT не найдена.";
                 return false;
             }
 
-            const qint64 sampleSize = _format.bitsPerSample / 8;
-            _samples.reserve(header.size / sampleSize);
-
-            switch (_format.audioFormat)
-            {
-            case PCM_INT:
-                switch (sampleSize)
-                {
-                case sizeof(quint8): // uint8
-                {
-                    quint8 sample;
-                    while (
-                        chunkEnd - fin.pos() >= sampleSize &&
-                        fin.read(reinterpret_cast<char*>(&sample), sampleSize) == sampleSize
-                    ) {
-                        // 128 в 8-битных WAV означает 0; qint8 - не ошибка, т.к. приводим к знаковому типу
-                        _samples.append((static_cast<qreal>(sample) - 128.0) / std::numeric_limits<qint8>::max());
-                    }
-                    break;
-                }
-
-                case sizeof(qint16): // int16
-                {
-                    qint16 sample;
-                    while (
-                        chunkEnd - fin.pos() >= sampleSize &&
-                        fin.read(reinterpret_cast<char*>(&sample), sampleSize) == sampleSize
-                    ) {
-                        _samples.append(static_cast<qreal>(sample) / std::numeric_limits<qint16>::max());
-                    }
-                    break;
-                }
-
-                case sizeof(qint32) - 1: // int24
-                {
-                    qint32 sample;
-                    while (
-                        chunkEnd - fin.pos() >= sampleSize &&
-                        fin.read(reinterpret_cast<char*>(&sample), sampleSize) == sampleSize
-                    ) {
-                        // Приводим к 32 битам, знаковый бит попадёт куда нужно
-                        _samples.append(static_cast<qreal>(sample << 8) / std::numeric_limits<qint32>::max());
-                    }
-                    break;
-                }
-
-                case sizeof(qint32): // int32
-                {
-                    qint32 sample;
-                    while (
-                        chunkEnd - fin.pos() >= sampleSize &&
-                        fin.read(reinterpret_cast<char*>(&sample), sampleSize) == sampleSize
-                    ) {
-                        _samples.append(static_cast<qreal>(sample) / std::numeric_limits<qint32>::max());
-                    }
-                    break;
-                }
-
-                default:
-                    fin.close();
-                    clear();
-                    QMessageBox::critical(nullptr, "Ошибка", "Неправильный размер сэмпла.");
-                    return false;
-                }
-                break;
-
-            case PCM_FLOAT:
-                switch (sampleSize)
-                {
-                case sizeof(float): // float32
-                {
-                    float sample;
-                    while (
-                        chunkEnd - fin.pos() >= sampleSize &&
-                        fin.read(reinterpret_cast<char*>(&sample), sampleSize) == sampleSize
-                    ) {
-                        _samples.append(static_cast<qreal>(sample));
-                    }
-                    break;
-                }
-
-                case sizeof(double): // float64
-                {
-                    double sample;
-                    while (
-                        chunkEnd - fin.pos() >= sampleSize &&
-                        fin.read(reinterpret_cast<char*>(&sample), sampleSize) == sampleSize
-                    ) {
-                        _samples.append(static_cast<qreal>(sample));
-                    }
-                    break;
-                }
-
-                default:
-                    fin.close();
-                    clear();
-                    QMessageBox::critical(nullptr, "Ошибка", "Неправильный размер сэмпла.");
-                    return false;
-                }
-                break;
-
-            default:
-                fin.close();
-                clear();
-                QMessageBox::critical(nullptr, "Ошибка", "Программа поддерживает только несжатые WAV.");
-                return false;
-            }
+            _dataOffset = fin.pos();
+            _dataSize = header.size;
             hasData = true;
             break;
         }
 
         // Переходим на конец секции (например, FORMAT_EX)
         if (!fin.seek(chunkEnd)) {
-            fin.close();
-            clear();
-            QMessageBox::critical(nullptr, "Ошибка", "Ошибка чтения.");
+            _errorString = "Ошибка чтения.";
             return false;
         }
     }
-    fin.close();
 
     if (!hasData) {
+        _errorString = "Секция DATA не найдена.";
+        return false;
+    }
+
+    if (_format.audioFormat != PCM_INT && _format.audioFormat != PCM_FLOAT) {
+        _errorString = "Программа поддерживает только несжатые WAV.";
+        return false;
+    }
+
+    const int sampleSize = _format.bitsPerSample / 8;
+    if (_format.audioFormat == PCM_INT ? sampleSize < 1 || sampleSize > 4 : sampleSize != 4 && sampleSize != 8) {
+        _errorString = "Неправильный размер сэмпла.";
+        return false;
+    }
+
+    if (_format.numChannels == 0 || _format.sampleRate == 0) {
+        _errorString = "Неправильный формат аудио.";
+        return false;
+    }
+
+    // Точное количество кадров известно уже по заголовку
+    _frames = _dataSize / (sampleSize * _format.numChannels);
+
+    return true;
+}
+
+bool WavReader::probe(const QString &fileName)
+{
+    clear();
+    _errorString.clear();
+    _warnings.clear();
+
+    QFile fin(fileName);
+    if (!fin.open(QIODevice::ReadOnly)) {
+        _errorString = "Не могу открыть файл для чтения.";
+        return false;
+    }
+
+    const bool result = readHeaders(fin);
+    fin.close();
+    if (!result) {
         clear();
-        QMessageBox::critical(nullptr, "Ошибка", "Секция DATA не найдена.");
+    }
+    return result;
+}
+
+bool WavReader::load(const QString &fileName, const bool planar)
+{
+    clear();
+    _errorString.clear();
+    _warnings.clear();
+    _planar = planar;
+
+    // Открытие файла
+    QFile fin(fileName);
+    if (!fin.open(QIODevice::ReadOnly)) {
+        _errorString = "Не могу открыть файл для чтения.";
         return false;
     }
 
+    if (!readHeaders(fin) || !fin.seek(_dataOffset)) {
+        fin.close();
+        clear();
+        if (_errorString.isEmpty()) {
+            _errorString = "Ошибка чтения.";
+        }
+        return false;
+    }
+
+    const qint64 chunkEnd = _dataOffset + _dataSize;
+    const qint64 sampleSize = _format.bitsPerSample / 8;
+    const int numChannels = _format.numChannels;
+    // Уровень считается окнами по 10 мс в том же проходе, что и декодирование
+    const qint64 window = qMax<qint64>(_format.sampleRate / 100, 1);
+    if (_planar) {
+        _channels.resize(numChannels);
+        for (SamplesList &channel : _channels) {
+            channel.reserve(_dataSize / sampleSize / numChannels);
+        }
+        _histograms.fill(Histogram::Histogram(window), numChannels);
+    } else {
+        _samples.reserve(_dataSize / sampleSize);
+        _histograms.fill(Histogram::Histogram(window), 1);
+    }
+
+    const qint64 read = _readAhead > 0 ? readAhead(fin, chunkEnd) : readBlocks(fin, chunkEnd);
+    fin.close();
+
+    // Секция DATA целиком помещается в файл (проверено по заголовку), значит данные оборвались из-за ошибки
+    if (read < _dataSize) {
+        clear();
+        _errorString = "Ошибка чтения.";
+        return false;
+    }
+
+    // Гистограммы каналов независимы и просто складываются
+    _histogram = _histograms.value(0);
+    _histogram.finish();
+    for (int i = 1; i < _histograms.size(); ++i) {
+        _histograms[i].finish();
+        _histogram.merge(_histograms.at(i));
+    }
+
     return true;
 }
 
 bool WavReader::isEmpty() const
 {
+    for (const SamplesList &channel : _channels) {
+        if (!channel.isEmpty()) {
+            return false;
+        }
+    }
     return _samples.isEmpty();
 }
 
+bool WavReader::isPlanar() const
+{
+    return _planar;
+}
+
 void WavReader::toMono()
 {
-    if (_format.numChannels < 2) {
+    if (_planar || _format.numChannels < 2) {
         return;
     }
 
-    for (int i = 0, j = 0, len = _samples.size(); i < len; i += _format.numChannels, ++j) {
-        _samples[j] = (_samples[i] + _samples[i + 1]) / 2.0;
+    const int numChannels = _format.numChannels;
+    const qsizetype frames = _samples.size() / numChannels;
+    for (qsizetype i = 0; i < frames; ++i) {
+        _samples[i] = mixdown(_samples.constData() + i * numChannels, numChannels);
     }
-    _samples.resize(_samples.size() / _format.numChannels);
+    _samples.resize(frames);
     _format.numChannels = 1u;
 }
 
@@ -289,4 +474,34 @@ const SamplesList &WavReader::samples()
 {
     return _samples;
 }
+
+qint64 WavReader::frames() const
+{
+    return _frames;
+}
+
+const QList<SamplesList> &WavReader::channels()
+{
+    return _channels;
+}
+
+const QString &WavReader::errorString() const
+{
+    return _errorString;
+}
+
+const QStringList &WavReader::warnings() const
+{
+    return _warnings;
+}
+
+const Histogram::Histogram &WavReader::histogram() const
+{
+    return _histogram;
+}
+
+const IngestStats &WavReader::ingestStats() const
+{
+    return _stats;
+}
 }
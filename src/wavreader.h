@@ -19,8 +19,13 @@
 #ifndef WAVREADER_H
 #define WAVREADER_H
 
+#include "histogram.h"
 #include <QString>
+#include <QFile>
+#include <QStringList>
 #include <QList>
+#include <cstring>
+#include <limits>
 
 namespace WavReader
 {
@@ -51,21 +56,124 @@ const quint32 ID_RIFF   = 0x46464952u, // RIFF
 const quint16 PCM_INT   = 1u,
               PCM_FLOAT = 3u;
 
+// Сэмплы в буфере могут быть не выровнены, поэтому копируем побайтно
+template<typename T>
+inline T readSample(const char *data)
+{
+    T sample;
+    std::memcpy(&sample, data, sizeof(T));
+    return sample;
+}
+
+// Приведение сэмплов к диапазону [-1; 1]
+inline qreal toReal(const quint8 sample)
+{
+    // 128 в 8-битных WAV означает 0; qint8 - не ошибка, т.к. приводим к знаковому типу
+    return (static_cast<qreal>(sample) - 128.0) / std::numeric_limits<qint8>::max();
+}
+
+inline qreal toReal(const qint16 sample)
+{
+    return static_cast<qreal>(sample) / std::numeric_limits<qint16>::max();
+}
+
+inline qreal toReal(const qint32 sample)
+{
+    return static_cast<qreal>(sample) / std::numeric_limits<qint32>::max();
+}
+
+inline qreal toReal(const float sample)
+{
+    return static_cast<qreal>(sample);
+}
+
+inline qreal toReal(const double sample)
+{
+    return static_cast<qreal>(sample);
+}
+
+inline qreal int24ToReal(const quint8 *bytes)
+{
+    // Собираем в старших 24 битах 32-битного числа, знаковый бит попадёт куда нужно
+    return toReal(static_cast<qint32>(static_cast<quint32>(bytes[0]) << 8 |
+                                      static_cast<quint32>(bytes[1]) << 16 |
+                                      static_cast<quint32>(bytes[2]) << 24));
+}
+
+// Упреждающее чтение: блоков прочитано и сколько ждала каждая сторона
+struct IngestStats
+{
+    qint64 blocks;
+    qint64 readerStall;  // мкс, читатель ждал свободный блок (упирается в декодирование)
+    qint64 decoderStall; // мкс, декодер ждал данные (упирается в диск)
+};
+
+const int DEFAULT_BLOCK_SIZE = 1 << 20;
+// Параметры приходят в том числе от клиентов демона, поэтому кольцо ограничено
+const int MAX_READ_AHEAD = 64;
+const qint64 MAX_BLOCK_SIZE = 64 << 20,
+             MAX_RING_SIZE  = 256 << 20;
+
+// Сведение кадра чередующихся каналов в моно: среднее всех каналов
+inline qreal mixdown(const qreal *frame, const int channels)
+{
+    qreal sum = 0.0;
+    for (int c = 0; c < channels; ++c) {
+        sum += frame[c];
+    }
+    return sum / channels;
+}
+
 class WavReader
 {
     FormatChunk _format;
     SamplesList _samples;
+    QList<SamplesList> _channels;
+    bool _planar;
+    int _channel;
+    qsizetype _mixed;       // сэмплов уже учтено в гистограмме
+    SamplesList _mixBuffer; // сведённые в моно кадры блока
+    QString _errorString;
+    QStringList _warnings;
+    Histogram::Histogram _histogram;
+    QList<Histogram::Histogram> _histograms;
+    qint64 _dataOffset;
+    qint64 _dataSize;
+    qint64 _frames;
+    int _readAhead;
+    qint64 _blockSize;
+    IngestStats _stats;
+
+    bool readHeaders(QFile &fin);
+    void appendSample(qreal sample);
+    qint64 alignedBlockSize() const;
+    void decodeSamples(const char *data, qint64 size);
+    void decode(const char *data, qint64 size);
+    qint64 readBlocks(QFile &fin, qint64 chunkEnd);
+    qint64 readAhead(QFile &fin, qint64 chunkEnd);
 
 public:
     explicit WavReader();
-    explicit WavReader(const QString &fileName);
+    explicit WavReader(const QString &fileName, bool planar = false);
 
     void clear();
-    bool load(const QString &fileName);
+    // Очистка с освобождением буферов, если они вместе больше keepSamples сэмплов
+    void release(qint64 keepSamples);
+    // depth - количество блоков в кольце потока чтения, 0 - читать и декодировать в одном потоке
+    void setReadAhead(int depth, qint64 blockSize = DEFAULT_BLOCK_SIZE);
+    bool probe(const QString &fileName);
+    bool load(const QString &fileName, bool planar = false);
     bool isEmpty() const;
+    bool isPlanar() const;
     void toMono();
     const FormatChunk &format();
+    qint64 frames() const;
     const SamplesList &samples();
+    const QList<SamplesList> &channels();
+    const QString &errorString() const;
+    const QStringList &warnings() const;
+    const Histogram::Histogram &histogram() const;
+    const IngestStats &ingestStats() const;
 };
 }
 